@@ -0,0 +1,111 @@
+// Batch
+
+/* Batch mode of both projects, which include it ahead of their program: many input files solved
+ * in one process, each into its own output file, by a solve function the project passes in */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Runs a whole job from the input in to the output out; throws on bad input
+typedef std::function<void(FILE *, FILE *)> Solve;
+
+// Files named on the command line, and the .in files of any directory among them, largest first
+void listInputs(const std::vector<const char *> &paths, std::vector<std::string> &inputs) {
+	std::vector< std::pair<off_t, std::string> > sized;
+	struct stat info;
+
+	for (const char *path : paths) {
+		DIR *dir = opendir(path);
+		if (dir == NULL) {
+			sized.push_back(std::make_pair(stat(path, &info) == 0 ? info.st_size : 0, path));
+			continue;
+		}
+		for (struct dirent *entry = readdir(dir); entry != NULL; entry = readdir(dir)) {
+			std::string name = entry->d_name;
+			std::string file = std::string(path) + "/" + name;
+			if (name.size() > 3 && name.compare(name.size() - 3, 3, ".in") == 0 && stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+				sized.push_back(std::make_pair(info.st_size, file));
+		}
+		closedir(dir);
+	}
+
+	std::stable_sort(sized.begin(), sized.end(),
+		[](const std::pair<off_t, std::string> &a, const std::pair<off_t, std::string> &b) { return a.first > b.first; });
+	for (const std::pair<off_t, std::string> &s : sized)
+		inputs.push_back(s.second);
+}
+
+// The output of some/where/name.in is outputDir/name.out
+std::string outputPath(const std::string &input, const char *outputDir) {
+	std::string name = input.substr(input.rfind('/') + 1);
+	if (name.size() > 3 && name.compare(name.size() - 3, 3, ".in") == 0)
+		name.resize(name.size() - 3);
+	return std::string(outputDir) + "/" + name + ".out";
+}
+
+/* One input file to its output file; false when either cannot be opened or the input is bad, and
+ * then there is no output file */
+bool processFile(const std::string &input, const char *outputDir, const Solve &solve) {
+	std::string output = outputPath(input, outputDir);
+	FILE *in = fopen(input.c_str(), "r");
+	FILE *out = in != NULL ? fopen(output.c_str(), "w") : NULL;
+
+	if (out == NULL) {
+		fprintf(stderr, "cannot process %s into %s\n", input.c_str(), output.c_str());
+		if (in != NULL)
+			fclose(in);
+		return false;
+	}
+	try {
+		solve(in, out);
+	}
+	catch (const std::exception &e) {
+		fprintf(stderr, "%s: %s\n", input.c_str(), e.what());
+		fclose(in);
+		fclose(out);
+		remove(output.c_str());
+		return false;
+	}
+	fclose(in);
+	fclose(out);
+	return true;
+}
+
+/* Every input as an independent job, on workers taking the next file as they finish one; each
+ * worker thread gets its own malloc arena, so the jobs do not contend for the heap. A job that
+ * runs threads of its own starts them itself, so it never waits on the workers of the batch */
+bool batch(const std::vector<std::string> &inputs, const char *outputDir, int workers, const Solve &solve) {
+	std::atomic<size_t> next(0);
+	std::atomic<bool> ok(true);
+	std::vector<std::thread> threads;
+
+	auto work = [&]() {
+		for (size_t i = next++; i < inputs.size(); i = next++)
+			if (!processFile(inputs[i], outputDir, solve))
+				ok = false;
+	};
+
+	if (workers <= 0)
+		workers = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < workers; i++)
+		threads.push_back(std::thread(work));
+	work();
+	for (std::thread &t : threads)
+		t.join();
+	return ok;
+}
+
+#endif
@@ -0,0 +1,236 @@
+// Benchmark
+
+/* Timings and report of the benchmark of both projects, which include it after their program:
+ * phases timed over repetitions as they are closed, reported per input as the "size seconds"
+ * lines of the results files, with a column derived from the size in between if asked, CSV or JSON */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*---------------------------------------
+|
+|    Timings
+|
+\----------------------------------------*/
+class Timings {
+
+		typedef std::chrono::steady_clock Clock;
+
+		std::vector<std::string>           _phases;
+		std::vector< std::vector<double> > _samples;
+		Clock::time_point                  _last;
+		double                             _total;
+		size_t                             _current;
+
+	public:
+
+		Timings() :
+			_total(0),
+			_current(0) {}
+
+		const std::vector<std::string> &phases() const { return _phases; }
+
+		void clear() {
+			_phases.clear();
+			_samples.clear();
+		}
+
+		// Starts a repetition
+		void start() {
+			_current = 0;
+			_total = 0;
+			_last = Clock::now();
+		}
+
+		// Closes the current phase
+		void lap(const char *phase) {
+			Clock::time_point now = Clock::now();
+			double elapsed = std::chrono::duration<double>(now - _last).count();
+
+			if (_current == _phases.size()) {
+				_phases.push_back(phase);
+				_samples.push_back(std::vector<double>());
+			}
+			_samples[_current++].push_back(elapsed);
+			_total += elapsed;
+			_last = now;
+		}
+
+		// Ends a repetition; the whole run is recorded as one more phase
+		void stop() {
+			if (_current == _phases.size()) {
+				_phases.push_back("total");
+				_samples.push_back(std::vector<double>());
+			}
+			_samples[_current].push_back(_total);
+		}
+
+		size_t reps(size_t phase) const { return _samples[phase].size(); }
+
+		// Nearest rank
+		double percentile(size_t phase, double p) const {
+			std::vector<double> sorted(_samples[phase]);
+			std::sort(sorted.begin(), sorted.end());
+			size_t rank = (size_t) ceil(p / 100 * sorted.size());
+			return sorted[rank > 0 ? rank - 1 : 0];
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Report
+|
+\----------------------------------------*/
+enum Format { TXT, CSV, JSON };
+
+class Report {
+
+		Format   _format;
+		FILE    *_out;
+		int      _entries;
+		double (*_derived)(long long);   // column between size and seconds in TXT, from the size; or NULL
+
+		// A JSON string: quotes, backslashes and control characters escaped
+		void json(const char *s) {
+			fputc('"', _out);
+			for (; *s; s++) {
+				unsigned char c = *s;
+				if (c == '"' || c == '\\')
+					fprintf(_out, "\\%c", c);
+				else if (c < 0x20)
+					fprintf(_out, "\\u%04x", c);
+				else
+					fputc(c, _out);
+			}
+			fputc('"', _out);
+		}
+
+		// A CSV field, quoted with its quotes doubled when it holds a comma, quote or line break
+		void csv(const char *s) {
+			if (strpbrk(s, ",\"\r\n") == NULL) {
+				fputs(s, _out);
+				return;
+			}
+			fputc('"', _out);
+			for (; *s; s++) {
+				if (*s == '"')
+					fputc('"', _out);
+				fputc(*s, _out);
+			}
+			fputc('"', _out);
+		}
+
+	public:
+
+		Report(Format format, FILE *out, double (*derived)(long long) = NULL) :
+			_format(format),
+			_out(out),
+			_entries(0),
+			_derived(derived) {}
+
+		void begin() {
+			if (_format == CSV)
+				fprintf(_out, "input,size,phase,reps,min,p10,median,p90,max\n");
+			else if (_format == JSON)
+				fprintf(_out, "[");
+		}
+
+		// TXT matches the "size [derived] seconds" lines of the results files, median of the whole run
+		void add(const char *input, long long size, const Timings &t) {
+			const std::vector<std::string> &phases = t.phases();
+
+			if (_format == TXT) {
+				fprintf(_out, "%lld", size);
+				if (_derived != NULL)
+					fprintf(_out, " %.0f", _derived(size));
+				fprintf(_out, " %.6f\n", t.percentile(phases.size() - 1, 50));
+				return;
+			}
+
+			if (_format == JSON) {
+				fprintf(_out, "%s\n\t{ \"input\": ", _entries ? "," : "");
+				json(input);
+				fprintf(_out, ", \"size\": %lld, \"phases\": [", size);
+			}
+
+			for (size_t i = 0; i < phases.size(); i++) {
+				if (_format == CSV) {
+					csv(input);
+					fprintf(_out, ",%lld,", size);
+					csv(phases[i].c_str());
+					fprintf(_out, ",%zu,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+						t.reps(i), t.percentile(i, 0), t.percentile(i, 10), t.percentile(i, 50),
+						t.percentile(i, 90), t.percentile(i, 100));
+				}
+				else {
+					fprintf(_out, "%s\n\t\t{ \"phase\": ", i ? "," : "");
+					json(phases[i].c_str());
+					fprintf(_out, ", \"reps\": %zu, \"min\": %.6f, \"p10\": %.6f, "
+						"\"median\": %.6f, \"p90\": %.6f, \"max\": %.6f }",
+						t.reps(i), t.percentile(i, 0), t.percentile(i, 10), t.percentile(i, 50),
+						t.percentile(i, 90), t.percentile(i, 100));
+				}
+			}
+
+			if (_format == JSON)
+				fprintf(_out, "\n\t] }");
+			_entries++;
+			fflush(_out);
+		}
+
+		void end() {
+			if (_format == JSON)
+				fprintf(_out, "\n]\n");
+		}
+
+};
+
+bool parseFormat(const char *name, Format &format) {
+	if (!strcmp(name, "txt"))
+		format = TXT;
+	else if (!strcmp(name, "csv"))
+		format = CSV;
+	else if (!strcmp(name, "json"))
+		format = JSON;
+	else
+		return false;
+	return true;
+}
+
+// Comma separated list of integers
+bool parseParams(const char *str, std::vector<long long> &list) {
+	char *end;
+	do {
+		list.push_back(strtoll(str, &end, 10));
+		if (end == str)
+			return false;
+		str = end + 1;
+	} while (*end == ',');
+	return *end == '\0';
+}
+
+bool readFile(const char *path, std::string &text) {
+	FILE *f = fopen(path, "r");
+	char buffer[1 << 16];
+	size_t read;
+
+	if (f == NULL)
+		return false;
+	text.clear();
+	while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		text.append(buffer, read);
+	fclose(f);
+	return true;
+}
+
+#endif
@@ -0,0 +1,325 @@
+// Profile
+
+/* Heap accounting and per-phase profiler of both projects, which include it ahead of their
+ * program: the replacements of operator new and delete count the heap for the profiler, which
+ * records wall time, hardware counters and memory for every phase it is told of */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <malloc.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/*---------------------------------------
+|
+|    Memory
+|
+\----------------------------------------*/
+/* Heap held through operator new, counted by the replacements below with the usable size of each
+ * block, and the most held since the last reset. Counting starts with the profiler; until then
+ * an allocation costs one test more than malloc. Blocks allocated while counting carry a header,
+ * so that only they are taken off the count when freed, never the blocks from before */
+class Memory {
+
+		/* Ahead of a counted block: its counted size, then the complement of its address. An
+		 * uncounted block has the size word of malloc's chunk there instead, which never holds
+		 * the high bits of the complement of a user space address */
+		struct alignas(alignof(max_align_t)) Header {
+			size_t    size;
+			uintptr_t tag;
+		};
+
+		static std::atomic<bool>      _counting;
+		static std::atomic<long long> _current;
+		static std::atomic<long long> _peak;
+
+	public:
+
+		// Once on, counting stays on
+		static void count()     { _counting = true;  }
+		static bool counting()  { return _counting;  }
+
+		static long long current() { return _current; }
+		static long long peak()    { return _peak;    }
+
+		static void resetPeak() { _peak = _current.load(); }
+
+		// A counted block of size bytes; NULL when malloc fails
+		static void *allocate(size_t size) {
+			Header *h = (Header *) malloc(sizeof(Header) + size);
+			if (h == NULL)
+				return NULL;
+			h->size = malloc_usable_size(h) - sizeof(Header);
+			h->tag = ~(uintptr_t) (h + 1);
+
+			long long now = _current += h->size;
+			long long peak = _peak;
+			while (now > peak && !_peak.compare_exchange_weak(peak, now));
+			return h + 1;
+		}
+
+		// The block malloc gave for p, taken off the count when it was counted
+		static void *release(void *p) {
+			if (!_counting)
+				return p;
+			Header *h = (Header *) p - 1;
+			if (h->tag != ~(uintptr_t) p)
+				return p;
+			_current -= h->size;
+			return h;
+		}
+
+};
+
+std::atomic<bool>      Memory::_counting(false);
+std::atomic<long long> Memory::_current(0);
+std::atomic<long long> Memory::_peak(0);
+
+// Never inlined, or GCC sees free paired with operator new and warns about the mismatch
+__attribute__((noinline)) void *operator new(size_t size) {
+	void *p = Memory::counting() ? Memory::allocate(size) : malloc(size > 0 ? size : 1);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+	if (p != NULL)
+		free(Memory::release(p));
+}
+
+void operator delete[](void *p) noexcept         { operator delete(p); }
+void operator delete(void *p, size_t) noexcept   { operator delete(p); }
+void operator delete[](void *p, size_t) noexcept { operator delete(p); }
+
+/*---------------------------------------
+|
+|    Profiler
+|
+\----------------------------------------*/
+/* Wall time and hardware counters per phase of main, through perf_event_open. Counters that
+ * cannot be opened (no PMU, perf_event_paranoid) are reported as missing; when the profiler is
+ * off every call returns at once.
+ * Memory is recorded along: heap held at the end of the phase, heap peak during the phase, peak
+ * RSS so far (getrusage), and the bytes of each structure as reported by the graph */
+class Profiler {
+
+		enum { CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, COUNTERS };
+
+		struct Phase {
+			std::string name;
+			double      wall;
+			long long   counters[COUNTERS];
+			long long   heap;
+			long long   heapPeak;
+			long long   maxRSS;     // KB
+		};
+
+		typedef std::chrono::steady_clock Clock;
+
+		bool               _enabled;
+		int                _fd[COUNTERS];
+		long long          _last[COUNTERS];
+		Clock::time_point  _lastTime;
+		std::vector<Phase> _phases;
+
+		std::vector< std::pair<std::string, size_t> > _structures;
+
+		std::function<void(const char *)> _hook;
+
+		static const char *counterName(int c) {
+			static const char *names[COUNTERS] = { "cycles", "instructions", "cache-misses", "branch-misses" };
+			return names[c];
+		}
+
+		// Counters of this process; inherited by threads started afterwards
+		static int open(unsigned long long config) {
+			struct perf_event_attr attr;
+
+			memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = config;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.inherit = 1;
+
+			return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		}
+
+		long long read(int c) const {
+			long long value;
+			if (_fd[c] < 0 || ::read(_fd[c], &value, sizeof(value)) != sizeof(value))
+				return -1;
+			return value;
+		}
+
+	public:
+
+		Profiler() :
+			_enabled(false) {
+			for (int c = 0; c < COUNTERS; c++)
+				_fd[c] = -1;
+		}
+
+		~Profiler() {
+			for (int c = 0; c < COUNTERS; c++)
+				if (_fd[c] >= 0)
+					close(_fd[c]);
+		}
+
+		bool enabled() const { return _enabled; }
+
+		// Opens the counters; phases are measured from here on
+		void start() {
+			static const unsigned long long configs[COUNTERS] = {
+				PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+				PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+			};
+
+			_enabled = true;
+			Memory::count();
+			Memory::resetPeak();
+			for (int c = 0; c < COUNTERS; c++) {
+				_fd[c] = open(configs[c]);
+				_last[c] = read(c);
+			}
+			_lastTime = Clock::now();
+		}
+
+		// Called with the name of every phase as it closes, whether the profiler was started or not
+		void hook(const std::function<void(const char *)> &hook) { _hook = hook; }
+
+		// Closes the current phase
+		void lap(const char *name) {
+			if (_hook)
+				_hook(name);
+			if (!_enabled)
+				return;
+
+			Phase phase;
+			Clock::time_point now = Clock::now();
+
+			phase.name = name;
+			phase.wall = std::chrono::duration<double>(now - _lastTime).count();
+			for (int c = 0; c < COUNTERS; c++) {
+				long long value = read(c);
+				phase.counters[c] = value >= 0 ? value - _last[c] : -1;
+				_last[c] = value;
+			}
+
+			struct rusage usage;
+			getrusage(RUSAGE_SELF, &usage);
+			phase.heap = Memory::current();
+			phase.heapPeak = Memory::peak();
+			phase.maxRSS = usage.ru_maxrss;
+			Memory::resetPeak();
+
+			_phases.push_back(phase);
+			_lastTime = Clock::now();
+		}
+
+		// Bytes held by each structure
+		void structures(const std::vector< std::pair<std::string, size_t> > &list) {
+			_structures.insert(_structures.end(), list.begin(), list.end());
+		}
+
+		// Peak over every phase
+		long long heapPeak() const {
+			long long peak = 0;
+			for (const Phase &p : _phases)
+				peak = std::max(peak, p.heapPeak);
+			return peak;
+		}
+
+		long long maxRSS() const { return _phases.empty() ? 0 : _phases.back().maxRSS; }
+
+		// Summary table, one line per phase plus the total, then the structures
+		void print(FILE *out) const {
+			Phase total;
+
+			total.name = "total";
+			total.wall = 0;
+			for (int c = 0; c < COUNTERS; c++)
+				total.counters[c] = 0;
+			total.heap = _phases.empty() ? 0 : _phases.back().heap;
+			total.heapPeak = heapPeak();
+			total.maxRSS = maxRSS();
+
+			fprintf(out, "%-14s %12s", "phase", "wall (s)");
+			for (int c = 0; c < COUNTERS; c++)
+				fprintf(out, " %15s", counterName(c));
+			fprintf(out, " %14s %14s %14s\n", "heap (B)", "heap peak (B)", "max RSS (KB)");
+
+			for (size_t i = 0; i <= _phases.size(); i++) {
+				const Phase &p = i < _phases.size() ? _phases[i] : total;
+
+				fprintf(out, "%-14s %12.6f", p.name.c_str(), p.wall);
+				for (int c = 0; c < COUNTERS; c++) {
+					if (p.counters[c] < 0)
+						fprintf(out, " %15s", "-");
+					else
+						fprintf(out, " %15lld", p.counters[c]);
+				}
+				fprintf(out, " %14lld %14lld %14lld\n", p.heap, p.heapPeak, p.maxRSS);
+
+				if (i < _phases.size()) {
+					total.wall += p.wall;
+					for (int c = 0; c < COUNTERS; c++)
+						total.counters[c] = p.counters[c] < 0 || total.counters[c] < 0 ? -1 : total.counters[c] + p.counters[c];
+				}
+			}
+
+			if (!_structures.empty())
+				fprintf(out, "\n%-14s %12s\n", "structure", "bytes");
+			for (const std::pair<std::string, size_t> &s : _structures)
+				fprintf(out, "%-14s %12zu\n", s.first.c_str(), s.second);
+		}
+
+		// Totals first, so that scripts can grep them from the first lines
+		void json(FILE *out) const {
+			double wall = 0;
+			for (const Phase &p : _phases)
+				wall += p.wall;
+
+			fprintf(out, "{ \"wall\": %.6f, \"heapPeak\": %lld, \"maxRSS\": %lld,\n", wall, heapPeak(), maxRSS());
+			fprintf(out, "\"structures\": {");
+			for (size_t i = 0; i < _structures.size(); i++)
+				fprintf(out, "%s \"%s\": %zu", i ? "," : "", _structures[i].first.c_str(), _structures[i].second);
+			fprintf(out, " },\n\"phases\": [");
+			for (size_t i = 0; i < _phases.size(); i++) {
+				const Phase &p = _phases[i];
+
+				fprintf(out, "%s\n\t{ \"phase\": \"%s\", \"wall\": %.6f", i ? "," : "", p.name.c_str(), p.wall);
+				for (int c = 0; c < COUNTERS; c++) {
+					if (p.counters[c] < 0)
+						fprintf(out, ", \"%s\": null", counterName(c));
+					else
+						fprintf(out, ", \"%s\": %lld", counterName(c), p.counters[c]);
+				}
+				fprintf(out, ", \"heap\": %lld, \"heapPeak\": %lld, \"maxRSS\": %lld }", p.heap, p.heapPeak, p.maxRSS);
+			}
+			fprintf(out, "\n] }\n");
+		}
+
+};
+
+#endif
@@ -0,0 +1,167 @@
+// Server
+
+/* Server mode of both projects, which include it ahead of their program: jobs in the input
+ * format of the project, taken from a Unix socket and answered on their own connection */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <cctype>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/*---------------------------------------
+|
+|    Server
+|
+\----------------------------------------*/
+/* A Unix socket that takes jobs in the input format and answers each one on its own connection
+ * with the output of the program. Connections are served one at a time and a connection may
+ * carry several jobs back to back; every reply is flushed as soon as it is complete. A job that
+ * fails is answered with an "error" line and its connection is closed, as the rest of it can no
+ * longer be told apart from the job; the server takes the next connection.
+ * SIGINT and SIGTERM stop the server once the connection being served is closed, and the socket
+ * file goes with it. A socket file that another server still listens on is left alone */
+class Server {
+
+		std::string _path;
+		int         _socket;
+
+		static int  _wake[2];   // pipe the signal handler writes to, read end polled along the socket
+
+		static void stop(int) {
+			int saved = errno;
+			ssize_t written = write(_wake[1], "", 1);
+			(void) written;
+			errno = saved;
+		}
+
+		// Skips the blank space between jobs; false once the client has closed its side
+		static bool more(FILE *in) {
+			int c;
+			while ((c = getc(in)) != EOF)
+				if (!isspace(c)) {
+					ungetc(c, in);
+					return true;
+				}
+			return false;
+		}
+
+		static bool listening(const struct sockaddr_un &address) {
+			int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+			bool live = probe >= 0 && connect(probe, (const struct sockaddr *) &address, sizeof(address)) == 0;
+			if (probe >= 0)
+				close(probe);
+			return live;
+		}
+
+	public:
+
+		Server(const char *path) :
+			_path(path),
+			_socket(socket(AF_UNIX, SOCK_STREAM, 0)) {
+			struct sockaddr_un address;
+			struct sigaction action;
+			struct stat info;
+
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			if (_socket < 0 || _path.size() >= sizeof(address.sun_path) || pipe(_wake) < 0) {
+				fprintf(stderr, "cannot open socket %s\n", path);
+				exit(1);
+			}
+			strcpy(address.sun_path, path);
+
+			// Only a socket nobody answers on is replaced
+			if (listening(address)) {
+				fprintf(stderr, "%s: another server is listening on it\n", path);
+				exit(1);
+			}
+			if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+				unlink(path);
+			if (bind(_socket, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(_socket, 16) < 0) {
+				perror(path);
+				exit(1);
+			}
+
+			fcntl(_wake[1], F_SETFL, O_NONBLOCK);
+			memset(&action, 0, sizeof(action));
+			action.sa_handler = stop;
+			action.sa_flags = SA_RESTART;
+			sigemptyset(&action.sa_mask);
+			sigaction(SIGINT, &action, NULL);
+			sigaction(SIGTERM, &action, NULL);
+
+			// A client leaving early must not take the server down with it
+			signal(SIGPIPE, SIG_IGN);
+		}
+
+		~Server() {
+			close(_socket);
+			unlink(_path.c_str());
+			close(_wake[0]);
+			close(_wake[1]);
+		}
+
+		// Runs job(in, out) for every job received; true once stopped by a signal, false when accept fails
+		template <class Job>
+		bool run(Job job) {
+			struct pollfd ready[2];
+
+			ready[0].fd = _socket;
+			ready[0].events = POLLIN;
+			ready[1].fd = _wake[0];
+			ready[1].events = POLLIN;
+
+			for (;;) {
+				if (poll(ready, 2, -1) < 0) {
+					if (errno == EINTR)
+						continue;
+					perror(_path.c_str());
+					return false;
+				}
+				if (ready[1].revents != 0)
+					return true;
+
+				int client = accept(_socket, NULL, NULL);
+				if (client < 0) {
+					if (errno == EINTR || errno == ECONNABORTED)
+						continue;
+					perror(_path.c_str());
+					return false;
+				}
+
+				FILE *in  = fdopen(client, "r");
+				FILE *out = fdopen(dup(client), "w");
+				try {
+					while (more(in)) {
+						job(in, out);
+						fflush(out);
+					}
+				}
+				catch (const std::exception &e) {
+					fprintf(out, "error: %s\n", e.what());
+					fprintf(stderr, "%s: job failed: %s\n", _path.c_str(), e.what());
+				}
+				fclose(in);
+				fclose(out);
+			}
+		}
+
+};
+
+int Server::_wake[2] = { -1, -1 };
+
+#endif
@@ -18,13 +18,18 @@ fi
 vertNo=500000
 edgeNo=500000
 sccs=125000
-reps=1
+reps=5
+warmup=1
 
 # Bounds and increment for consecutive tests
 lower=100
 incr=100000
 upper=1000000
-upperVG=1000000
+
+# Memory tests reach 10M vertices; no valgrind, so they run at full speed
+lowerVG=1000000
+incrVG=1000000
+upperVG=10000000
 
 # Directories
 currentDir=$(pwd);
@@ -33,19 +38,18 @@ currentDir=$(pwd);
 work="$2"
 
 # Generator variables
-genZip=gerador.zip
-gen="${currentDir}/gerador"
+gen="${currentDir}/generator"
 
 # Public tests variables
 testsZip="students-tests.zip"
 tests="students-tests"
 
 bin="p1";
-time="/usr/bin/time"
-valgrind="valgrind --tool=massif"
+bench="p1-bench"
 
 # Compile project
-(g++ -Wall -O3 -o $bin -lm $1)
+(g++ -Wall -O3 -pthread -o $bin -lm $1)
+(g++ -Wall -O3 -pthread -o $bench -lm -DPROJECT_SOURCE="\"$1\"" benchmark.cpp)
 
 
 # Runs tests
@@ -65,15 +69,15 @@ if [ "$work" == "tests" ]; then
 
 	rm -rf $tests
 
-	rm -f $bin
+	rm -f $bin $bench
 
 	# If running tests only, script ends here
 	exit
 
 fi
 
-# Unzips graph generator
-(unzip $genZip)
+# Compiles graph generator
+(g++ -Wall -O3 -pthread -o $gen generator.cpp)
 
 # Running time tests
 if [ "$work" != "mem" ]; then
@@ -84,16 +88,9 @@ if [ "$work" != "mem" ]; then
 
 	# Runs tests for plotting; variable edges
 	for edge in $(seq $lower $incr $upper); do
-		($gen $vertNo $edge $sccs > graph-${vertNo}-${edge}-${sccs}-def.in)
-		for i in $(seq $reps); do
-			res=$( $time -f "%e" ./$bin < graph-${vertNo}-${edge}-${sccs}-def.in 2>&1 > /dev/null )
-			sum=$(( vertNo + edge ))
-			( printf "%s %s\n" $sum $res )
-		done
+		./$bench -w $warmup -r $reps -f txt -g $vertNo,$edge,$sccs
 	done
 
-	rm -f graph-*.in
-
 	sleep 1
 
 	echo "Running time tests; variable vertices"
@@ -101,16 +98,9 @@ if [ "$work" != "mem" ]; then
 	# Runs tests for plotting; variable vertices
 	for vert in $(seq $lower $incr $upper); do
 		sccs=$((vert / 4))
-		($gen $vert $edgeNo $sccs > graph-${vert}-${edgeNo}-${sccs}-def.in)
-		for i in $(seq $reps); do
-			res=$($time -f "%e" ./$bin < graph-${vert}-${edgeNo}-${sccs}-def.in 2>&1 > /dev/null)
-			sum=$(( vert + edgeNo ))
-			( printf "%s %s\n" $sum $res )
-		done
+		./$bench -w $warmup -r $reps -f txt -g $vert,$edgeNo,$sccs
 	done
 
-	rm -f graph-*.in
-
 	sleep 1
 
 	echo "Running time tests; #edges = #vertices"
@@ -118,16 +108,9 @@ if [ "$work" != "mem" ]; then
 	# Runs tests for plotting; #edges = #vertices
 	for q in $(seq $lower $incr $upper); do
 		sccs=$((q / 5))
-		($gen $q $q $sccs > graph-${q}-${q}-${sccs}-def.in)
-		for i in $(seq $reps); do
-			res=$($time -f "%e" ./$bin < graph-${q}-${q}-${sccs}-def.in 2>&1 > /dev/null)
-			sum=$(( q + q ))
-			( printf "%s %s\n" $sum $res )
-		done
+		./$bench -w $warmup -r $reps -f txt -g $q,$q,$sccs
 	done
 
-	rm -f graph-*.in
-
 fi
 
 # Running memory tests
@@ -138,29 +121,23 @@ if [ "$work" != "time" ]; then
 	echo "Running memory tests; #edges = #vertices"
 
 	# Runs tests for plotting; #edges = #vertices
-	for q in $(seq $lower $incr $upperVG); do
+	for q in $(seq $lowerVG $incrVG $upperVG); do
 		sccs=$((q / 5))
 
-		($gen $q $q $sccs > graph-${q}-${q}-${sccs}-def.in)
-		($valgrind ./$bin   < graph-${q}-${q}-${sccs}-def.in)
+		# Generated straight into the project, so no graph file piles up on disk
+		($gen $q $q $sccs | ./$bin -P mem.json > /dev/null)
 
 		sum=$(( q + q ))
-		memTotal=0;
-		timeRes=$(cat massif.* | grep -B 4 "peak" | grep "time" | awk -F '=' '{print $2}')
-		for element in $(cat massif.* | grep -B 3 "peak" | grep -v "peak" | tr "\n" "\t"); do
-			memory=${element##*=}
-			memTotal=$(( memTotal + memory ))
-		done
-		rm -f massif.*
+		memTotal=$(grep -o '"heapPeak": [0-9]*' mem.json | head -1 | awk '{print $2}')
+		timeRes=$(grep -o '"wall": [0-9.]*' mem.json | head -1 | awk '{print $2}')
+		rm -f mem.json
 		( printf "%s %s %s\n" $sum $memTotal $timeRes )
 	done
 
-	rm -f graph-*.in
-
 fi
 
 # Remove generator
 rm -f $gen
 
-# Remove compiled file
-rm -f $bin
\ No newline at end of file
+# Remove compiled files
+rm -f $bin $bench
\ No newline at end of file
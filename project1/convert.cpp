@@ -0,0 +1,148 @@
+// Convert
+
+/* Text input to the binary format of project_final (GraphHeader, then the adjacency offsets and
+ * edge ends of the CSR), so that runs on it start without parsing. Edges keep the order of the
+ * text within every vertex, as after Graph::sortByStart. The edges go to a temporary file as they
+ * are read, and the edge ends are then written in windows of at most WINDOW edges, one pass over
+ * the file per window, so memory is the offsets plus one window whatever the number of edges.
+ * Offsets are ints while the edges fit, long longs beyond */
+
+#define PROJECT_NO_MAIN
+#ifndef PROJECT_SOURCE
+#define PROJECT_SOURCE "project_final.cpp"
+#endif
+#include PROJECT_SOURCE
+
+// Next non-negative integer of in up to max, without the overhead of fscanf; false at the end or on anything else
+bool readNumber(FILE *in, long long &value, long long max) {
+	int c = getc_unlocked(in);
+
+	while (c == ' ' || c == '\n' || c == '\r' || c == '\t')
+		c = getc_unlocked(in);
+	if (c < '0' || c > '9')
+		return false;
+
+	for (value = 0; c >= '0' && c <= '9'; c = getc_unlocked(in)) {
+		value = value * 10 + (c - '0');
+		if (value > max)
+			return false;
+	}
+	return true;
+}
+
+bool readInt(FILE *in, int &value) {
+	long long v;
+	if (!readNumber(in, v, INT_MAX))
+		return false;
+	value = (int) v;
+	return true;
+}
+
+// Edge ends held at once while writing them, and so edges read back from the spool per pass
+static const long long WINDOW = 1LL << 26;
+
+/* The header and offsets, as wide as the edge count needs, then the edge ends of the spooled
+ * edges by start; offsets[v] is the first edge of vertex v on entry, and is used up as the next
+ * free slot of v */
+template <class Offset>
+bool write(FILE *out, FILE *spool, int vertexNo, std::vector<long long> &offsets) {
+	GraphHeader<Offset> header;
+	long long edgeNo = offsets[vertexNo];
+
+	memcpy(header.magic, GraphHeader<Offset>::tag(), 4);
+	header.vertexNo = vertexNo;
+	header.edgeNo = edgeNo;
+	if (fwrite(&header, sizeof(header), 1, out) != 1)
+		return false;
+
+	{
+		std::vector<Offset> narrow(offsets.begin(), offsets.end());
+		if (fwrite(narrow.data(), sizeof(Offset), narrow.size(), out) != narrow.size())
+			return false;
+	}
+
+	// Vertices first .. last - 1 in every window, at least one of them however many edges it has
+	std::vector<int> targets;
+	for (int first = 0, last; first < vertexNo; first = last) {
+		long long base = offsets[first];
+		for (last = first + 1; last < vertexNo && offsets[last + 1] - base <= WINDOW; last++)
+			;
+		targets.resize(offsets[last] - base);
+
+		int edge[2];
+		rewind(spool);
+		for (long long i = 0; i < edgeNo; i++) {
+			if (fread(edge, sizeof(edge), 1, spool) != 1)
+				return false;
+			if (edge[0] >= first && edge[0] < last)
+				targets[offsets[edge[0]]++ - base] = edge[1];
+		}
+		if (fwrite(targets.data(), sizeof(int), targets.size(), out) != targets.size())
+			return false;
+	}
+
+	return fflush(out) == 0;
+}
+
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-l] < input > input.bin\n", name);
+	fprintf(stderr, " input : a graph in the text format of project_final, \"V E\" and then E edges\n");
+	fprintf(stderr, " -l    : long long offsets even when ints are enough\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+	int vertexNo;
+	long long edgeNo;
+	bool wide = false;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-l"))
+			wide = true;
+		else
+			usage(argv[0]);
+	}
+
+	if (!readInt(stdin, vertexNo) || !readNumber(stdin, edgeNo, LLONG_MAX / 16) || vertexNo < 1) {
+		fprintf(stderr, "%s: bad header\n", argv[0]);
+		return 1;
+	}
+
+	// Edges as index pairs into the spool, counted by start
+	FILE *spool = tmpfile();
+	std::vector<long long> offsets(vertexNo + 1, 0);
+	int edge[2];
+
+	if (spool == NULL) {
+		fprintf(stderr, "%s: cannot create a temporary file\n", argv[0]);
+		return 1;
+	}
+
+	for (long long i = 0; i < edgeNo; i++) {
+		if (!readInt(stdin, edge[0]) || !readInt(stdin, edge[1]) ||
+			edge[0] < 1 || edge[0] > vertexNo || edge[1] < 1 || edge[1] > vertexNo) {
+			fprintf(stderr, "%s: bad edge %lld\n", argv[0], i + 1);
+			return 1;
+		}
+		offsets[edge[0]]++;
+		edge[0]--;
+		edge[1]--;
+		if (fwrite(edge, sizeof(edge), 1, spool) != 1) {
+			fprintf(stderr, "%s: cannot write the temporary file\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// Counts were kept one slot up, so the sums make offsets[v] the first edge of vertex v
+	for (int v = 1; v <= vertexNo; v++)
+		offsets[v] += offsets[v - 1];
+
+	if (!(wide || edgeNo > INT_MAX ? write<long long>(stdout, spool, vertexNo, offsets) : write<int>(stdout, spool, vertexNo, offsets))) {
+		fprintf(stderr, "%s: cannot write the output\n", argv[0]);
+		return 1;
+	}
+
+	return 0;
+
+}
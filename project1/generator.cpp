@@ -0,0 +1,282 @@
+// Generator
+
+/* Random graphs with an exact number of SCCs, taking the parameters of gerador: vertices, edges,
+ * SCCs, minimum and maximum SCC size and seed. The vertices are shuffled and split into SCCs,
+ * each one closed by a cycle; the remaining edges are random but only go from earlier SCCs to
+ * later ones. When the cycles alone take more than the requested edges, those are written anyway.
+ *
+ * Edges are produced in fixed size chunks, each with its own random stream, so the output only
+ * depends on the seed, never on the number of threads */
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*---------------------------------------
+|
+|    Random
+|
+\----------------------------------------*/
+// splitmix64; one independent stream per chunk
+class Random {
+
+		uint64_t _state;
+
+	public:
+
+		Random(uint64_t seed, uint64_t stream) :
+			_state(seed * 0x9E3779B97F4A7C15ULL + stream * 0xD1B54A32D192ED03ULL) {}
+
+		uint64_t next() {
+			uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+		// Uniform in [0, n)
+		int below(int n) { return (int) (next() % (uint64_t) n); }
+
+};
+
+/*---------------------------------------
+|
+|    Generator
+|
+\----------------------------------------*/
+class Generator {
+
+		static const int CHUNK = 1 << 16;
+
+		int      _vertexNo;
+		int      _edgeNo;
+		int      _sccNo;
+		int      _minSize;
+		int      _maxSize;
+		uint64_t _seed;
+
+		std::vector<int> _label;  // vertex at each position
+		std::vector<int> _scc;    // SCC of each position; SCCs hold consecutive positions
+		std::vector<int> _first;  // first position of each SCC, plus one past the last
+
+		int _cycleNo;             // edges closing the SCCs
+		int _extraNo;             // random edges between or inside SCCs
+
+		static void append(std::string &text, int value) {
+			char buffer[12];
+			int i = sizeof(buffer);
+			do {
+				buffer[--i] = '0' + value % 10;
+				value /= 10;
+			} while (value > 0);
+			text.append(buffer + i, sizeof(buffer) - i);
+		}
+
+		// Shuffles the vertices and draws the SCC sizes
+		void layout() {
+			Random random(_seed, 0);
+			int left = _vertexNo - _sccNo * _minSize;
+			int room = _maxSize - _minSize;
+
+			_label.resize(_vertexNo);
+			for (int p = 0; p < _vertexNo; p++)
+				_label[p] = p + 1;
+			for (int p = _vertexNo - 1; p > 0; p--)
+				std::swap(_label[p], _label[random.below(p + 1)]);
+
+			/* Every SCC takes an extra around the average of what is left, within what the
+			 * following ones can still absorb */
+			_first.assign(1, 0);
+			_scc.resize(_vertexNo);
+			_cycleNo = 0;
+			for (int k = 0; k < _sccNo; k++) {
+				int low = std::max(0, left - (_sccNo - k - 1) * room);
+				int average = (left + _sccNo - k - 1) / (_sccNo - k);
+				int high = std::max(low, std::min(std::min(room, left), 2 * average));
+				int size = _minSize + low + random.below(high - low + 1);
+
+				for (int p = _first.back(); p < _first.back() + size; p++)
+					_scc[p] = k;
+				if (size > 1)
+					_cycleNo += size;
+				_first.push_back(_first.back() + size);
+				left -= size - _minSize;
+			}
+
+			_extraNo = _vertexNo > 1 ? std::max(0, _edgeNo - _cycleNo) : 0;
+		}
+
+		// Cycle edges of positions [begin, end)
+		void cycles(int begin, int end, std::string &text) {
+			for (int p = begin; p < end; p++) {
+				int k = _scc[p];
+				if (_first[k + 1] - _first[k] < 2)
+					continue;
+
+				int next = p + 1 < _first[k + 1] ? p + 1 : _first[k];
+				append(text, _label[p]);
+				text += ' ';
+				append(text, _label[next]);
+				text += '\n';
+			}
+		}
+
+		// Random edges; never from a later SCC to an earlier one
+		void extras(int chunk, int count, std::string &text) {
+			Random random(_seed, chunk + 1);
+
+			for (int i = 0; i < count; i++) {
+				int p = random.below(_vertexNo);
+				int q = random.below(_vertexNo - 1);
+				if (q >= p)
+					q++;
+				if (_scc[p] > _scc[q])
+					std::swap(p, q);
+
+				append(text, _label[p]);
+				text += ' ';
+				append(text, _label[q]);
+				text += '\n';
+			}
+		}
+
+	public:
+
+		Generator(int vertexNo, int edgeNo, int sccNo, int minSize = 1, int maxSize = 10, uint64_t seed = 0) :
+			_vertexNo(vertexNo),
+			_edgeNo(edgeNo),
+			_sccNo(sccNo),
+			_minSize(minSize),
+			_maxSize(maxSize),
+			_seed(seed),
+			_cycleNo(0),
+			_extraNo(0) {}
+
+		// Same restrictions as gerador
+		const char *check() const {
+			if (_vertexNo < 1 || _edgeNo < 0 || _sccNo < 1 || _minSize < 1 || _maxSize < _minSize)
+				return "parameters out of range";
+			if ((long long) _sccNo * _maxSize < _vertexNo)
+				return "#SCCs * max cannot be smaller than #V";
+			if ((long long) _sccNo * _minSize > _vertexNo)
+				return "#SCCs * min cannot be larger than #V";
+			return NULL;
+		}
+
+		int edges() const { return _cycleNo + _extraNo; }
+
+		/* Text of the whole input in order, one string per chunk; threads <= 0 uses every
+		 * core */
+		void generate(std::vector<std::string> &chunks, int threads = 0) {
+			layout();
+
+			int cycleChunks = (_vertexNo + CHUNK - 1) / CHUNK;
+			int extraChunks = (_extraNo + CHUNK - 1) / CHUNK;
+			std::atomic<int> next(0);
+			std::vector<std::thread> workers;
+
+			chunks.assign(cycleChunks + extraChunks + 1, std::string());
+			chunks[0] += std::to_string(_vertexNo) + "\n" + std::to_string(edges()) + "\n";
+
+			auto work = [&]() {
+				for (int c = next++; c < cycleChunks + extraChunks; c = next++) {
+					std::string &text = chunks[c + 1];
+					text.reserve(CHUNK * 16);
+					if (c < cycleChunks)
+						cycles(c * CHUNK, std::min(_vertexNo, (c + 1) * CHUNK), text);
+					else {
+						int e = c - cycleChunks;
+						extras(e, std::min(CHUNK, _extraNo - e * CHUNK), text);
+					}
+				}
+			};
+
+			if (threads <= 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+			for (int i = 1; i < threads; i++)
+				workers.push_back(std::thread(work));
+			work();
+			for (std::thread &w : workers)
+				w.join();
+		}
+
+		std::string text(int threads = 0) {
+			std::vector<std::string> chunks;
+			std::string all;
+			size_t size = 0;
+
+			generate(chunks, threads);
+			for (const std::string &c : chunks)
+				size += c.size();
+			all.reserve(size);
+			for (const std::string &c : chunks)
+				all += c;
+			return all;
+		}
+
+		void write(FILE *out, int threads = 0) {
+			std::vector<std::string> chunks;
+
+			generate(chunks, threads);
+			for (const std::string &c : chunks)
+				fwrite(c.data(), 1, c.size(), out);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    main
+|
+|----------------------------------------*/
+#ifndef GENERATOR_NO_MAIN
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-j threads] #V #E #SCCs [min [max [seed]]] > input\n", name);
+	fprintf(stderr, " #V         : number of vertices\n");
+	fprintf(stderr, " #E         : number of edges; more are written when the SCC cycles need them\n");
+	fprintf(stderr, " #SCCs      : exact number of strongly connected components\n");
+	fprintf(stderr, " min, max   : bounds on the size of each SCC (default 1 and 10)\n");
+	fprintf(stderr, " seed       : seed for the random streams (default 0)\n");
+	fprintf(stderr, " -j threads : threads writing the edges; 0 uses every core (default)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+	int threads = 0;
+	std::vector<long long> params;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (argv[i][0] == '-')
+			usage(argv[0]);
+		else
+			params.push_back(atoll(argv[i]));
+	}
+
+	if (params.size() < 3 || params.size() > 6)
+		usage(argv[0]);
+
+	Generator gen(params[0], params[1], params[2],
+		params.size() > 3 ? params[3] : 1,
+		params.size() > 4 ? params[4] : 10,
+		params.size() > 5 ? params[5] : 0);
+
+	if (gen.check() != NULL) {
+		fprintf(stderr, "%s: %s\n", argv[0], gen.check());
+		usage(argv[0]);
+	}
+
+	gen.write(stdout, threads);
+
+	return 0;
+
+}
+#endif
@@ -1,10 +1,44 @@
 // Project
 
 #include <vector>
-#include <list>
-#include <stack>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <random>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 
+#include <malloc.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <limits>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <stdexcept>
+
+#include "../common/profile.h"
+#include "../common/server.h"
+#include "../common/batch.h"
+
+/* Input that breaks the format; the run that reads it fails, and only that one, so the server
+ * and batch modes go on with the next job */
+struct BadInput : std::runtime_error {
+	BadInput(const std::string &what) : std::runtime_error(what) {}
+};
+
+// Edges the engines look ahead when prefetching, off until measured on the target; -d overrides it
+#ifndef PREFETCH_DISTANCE
+#define PREFETCH_DISTANCE 0
+#endif
+
 /*---------------------------------------
 |
 |    Vertex
@@ -14,36 +48,23 @@
 class Vertex {
 
 		int  _key;
-		int  _discovery;
-		int  _lowlink;
-		bool _onStack;
+		int  _discovery;    // -1 until Trim peels the vertex; the search keeps its own indices
 
 	public:
 
 		Vertex(int key) :
 			_key(key),
-			_discovery(-1),
-			_lowlink(-1),
-			_onStack(false) {}
+			_discovery(-1) {}
 
 		int key()       const { return _key;       }
 		int discovery() const { return _discovery; }
-		int lowlink()   const { return _lowlink;   }
 
 		void key(int k)       { _key       = k;   }
 		void discovery(int d) { _discovery = d;   }
-		void lowlink(int ll)  { _lowlink   = ll;  }
-		void onStack(bool b)  { _onStack   = b;   }
-		
-		bool onStack()      const { return _onStack;         }
+
 		bool undiscovered() const { return _discovery == -1; }
 		bool isValid()      const { return _key >= 1;        }
 
-		void lowerlink(const Vertex &v) {
-			if (_lowlink > v.lowlink())
-				_lowlink = v.lowlink();
-		}
-
 		friend bool operator!=(const Vertex &v1, const Vertex &v2) {
 			return v1.key() != v2.key();
 		}
@@ -95,6 +116,7 @@ class Graph {
 		std::vector<Vertex*> _vertices;
 		std::vector<Edge*>   _edges;
 		std::vector<int>     _adjacency;
+		std::vector<int>     _targets;    // end of every edge as a vertex index, by start
 
 	public:
 
@@ -115,29 +137,58 @@ class Graph {
 		Edge *edge(int position) {
 			if (position >= 0 && position < _edgeNo)
 				return _edges[position];
-			exit(1);
+			throw BadInput("edge " + std::to_string(position) + " out of range");
 		}
 
 		Vertex *vertex(int key) {
 			if (key > 0 && key <= _vertexNo)
 				return _vertices[key - 1];
-			exit(1);
+			throw BadInput("vertex " + std::to_string(key) + " out of range");
 		}
 
 		int adjStart(Edge *e)   const { return _adjacency[e->begin()->key() - 1]; }
 		int adjSize (Edge *e)   const { return _adjacency[e->begin()->key()] - _adjacency[e->begin()->key() - 1]; }
 		int adjStart(Vertex *v) const { return _adjacency[v->key() - 1]; }
 		int adjSize (Vertex *v) const { return _adjacency[v->key()] - _adjacency[v->key() - 1]; }
+
+		// Integer view; vertex i is the one created with key i + 1
+		typedef int Offset;
+		int size()          const { return _vertexNo;         }
+		int adjStart(int i) const { return _adjacency[i];     }
+		int adjEnd(int i)   const { return _adjacency[i + 1]; }
+		int target(int e)   const { return _targets[e];       }
+		int original(int i) const { return i;                 }
+
+		// Adjacency offset of vertex i into the cache, ahead of a visit
+		void prefetch(int i) const { __builtin_prefetch(&_adjacency[i]); }
+
+		// Cursor over the out-edges of vertex i, as the CSR engines walk them
+		typedef int Cursor;
+		Cursor cursor(int i)                  const { return adjStart(i); }
+		bool more(int i, Cursor e)            const { return e < adjEnd(i); }
+		int next(Cursor &e)                   const { return target(e++); }
+		int peek(int i, Cursor e, int ahead)  const { return e + ahead < adjEnd(i) ? target(e + ahead) : -1; }
+
+		// Labels of the CSR engines; a peeled vertex is already a complete SCC
+		bool peeled(int i) const     { return !_vertices[i]->undiscovered(); }
+		void label(int i, int key)   { _vertices[i]->key(key); }
+		void peel(int i, int key)    { _vertices[i]->discovery(0); _vertices[i]->key(key); }
 		//-------------------------------------------------------------
 
 		void incrementSCC() { _sccNo++; }
 
+		// Counts as Dynamic keeps them, merging components and their connections
+		int  sccNo()     const { return _sccNo;     }
+		int  connectNo() const { return _connectNo; }
+		void changeSCC(int n)     { _sccNo += n;     }
+		void changeConnect(int n) { _connectNo += n; }
+
 		// Adds vertex to array
 		void addVertex(Vertex *v) {
 			if (v->isValid())
 				_vertices[v->key() - 1] = v;
 			else
-				exit(1);
+				throw BadInput("vertex " + std::to_string(v->key()) + " out of range");
 		}
 
 		// Adds edge to array
@@ -147,7 +198,7 @@ class Graph {
 				_adjacency[edge->begin()->key() - 1] += 1;
 			}
 			else
-				exit(1);
+				throw BadInput("edge " + std::to_string(position) + " out of range");
 		}
 
 		// Counting Sort by edge end
@@ -208,6 +259,16 @@ class Graph {
 				_adjacency[i] += _adjacency[i - 1];
 		}
 
+		/* Edge ends as indices, in adjacency order; built once, before any relabelling, while
+		 * keys still identify the vertices */
+		void generateTargets() {
+			if (_targets.size() == (size_t) _edgeNo)
+				return;
+			_targets.resize(_edgeNo);
+			for (int i = 0; i < _edgeNo; i++)
+				_targets[i] = _edges[i]->end()->key() - 1;
+		}
+
 
 		// Calculates number of connections between SCCs
 		void connectionsNumber() {
@@ -222,140 +283,3016 @@ class Graph {
 
 		}
 
+		/* Bytes held by each structure; sort buffers are the ones of a single counting sort,
+		 * freed when it returns */
+		std::vector< std::pair<std::string, size_t> > memory() const {
+			std::vector< std::pair<std::string, size_t> > usage;
+
+			usage.push_back(std::make_pair("vertices", _vertices.capacity() * sizeof(Vertex*) + _vertexNo * sizeof(Vertex)));
+			usage.push_back(std::make_pair("edges", _edges.capacity() * sizeof(Edge*) + _edgeNo * sizeof(Edge)));
+			usage.push_back(std::make_pair("adjacency", _adjacency.capacity() * sizeof(int)));
+			usage.push_back(std::make_pair("targets", _targets.capacity() * sizeof(int)));
+			usage.push_back(std::make_pair("sortBuffers", _edgeNo * sizeof(Edge*) + (_vertexNo + 1) * sizeof(int)));
+			return usage;
+		}
+
 		// Prints output
-		void print() {
+		void print(FILE *out = stdout) {
 			Edge *prev = NULL;
 
-			fprintf(stdout, "%d\n", _sccNo);
-			fprintf(stdout, "%d\n", _connectNo);
+			fprintf(out, "%d\n", _sccNo);
+			fprintf(out, "%d\n", _connectNo);
 
 			for (Edge *e : _edges) {
 				if (e->begin()->key() == e->end()->key() || (prev != NULL && *e == *prev)) continue;
 
-				fprintf(stdout, "%d %d\n", e->begin()->key(), e->end()->key());
+				fprintf(out, "%d %d\n", e->begin()->key(), e->end()->key());
 				prev = e;
 			}
 		}
 
+		// Reads every edge after the "V E" header; creation of objects
+		void load(FILE *in) {
+			int edgeStart;
+			int edgeEnd;
+
+			for (int i = 1; i <= _vertexNo; i++)
+				addVertex(new Vertex(i));
+
+			for (int i = 0; i < _edgeNo; i++) {
+				if (fscanf(in, "%d %d", &edgeStart, &edgeEnd) != 2)
+					throw BadInput("edge " + std::to_string(i + 1) + " missing");
+				addEdge(new Edge(vertex(edgeStart), vertex(edgeEnd)), i);
+			}
+		}
+
+		// Deletion of objects; whatever a failed load created goes with the graph
+		void unload() {
+			for (Edge *e : _edges)
+				delete e;
+			for (Vertex *v : _vertices)
+				delete v;
+			_edges.clear();
+			_vertices.clear();
+		}
+
+		~Graph() { unload(); }
+
 };
 
 /*---------------------------------------
 |
-|    SCCFinder
+|    Mapping
 |
 \----------------------------------------*/
-class SCCFinder {
+/* The bytes of a binary input. A regular file read from its start is mapped and faulted in at
+ * once, so it is used where it lies in the page cache; any other stream (pipe, socket) is copied,
+ * reading exactly the size of the input and no further */
+class Mapping {
+
+		const char        *_data;
+		size_t             _size;
+		bool               _mapped;
+		std::vector<char>  _copy;
+
+	public:
+
+		// The first done bytes, the header, were already read from in into header
+		Mapping(FILE *in, const void *header, size_t done, size_t size) :
+			_data(NULL),
+			_size(size),
+			_mapped(false) {
+			struct stat info;
+
+			if (fstat(fileno(in), &info) == 0 && S_ISREG(info.st_mode) &&
+				(size_t) info.st_size >= size && ftell(in) == (long) done) {
+				void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fileno(in), 0);
+				if (data != MAP_FAILED) {
+					_data = (const char *) data;
+					_mapped = true;
+					return;
+				}
+			}
+
+			_copy.resize(size);
+			memcpy(_copy.data(), header, done);
+			if (fread(_copy.data() + done, 1, size - done, in) != size - done)
+				throw BadInput("binary input shorter than its header says");
+			_data = _copy.data();
+		}
+
+		~Mapping() {
+			if (_mapped)
+				munmap((void *) _data, _size);
+		}
+
+		const char *data() const { return _data; }
+		size_t size()      const { return _size; }
+
+};
+
+/*---------------------------------------
+|
+|    MappedGraph
+|
+\----------------------------------------*/
+/* Binary input, as written by convert: the header below, then V + 1 adjacency offsets and E edge
+ * ends, all native. Vertex i is the one with key i + 1 and its out-edges go to
+ * targets[offsets[i]] .. targets[offsets[i + 1] - 1]. Ends are ints; offsets are ints as well
+ * unless E needs more than 31 bits, and then long longs */
+template <class Offset>
+struct GraphHeader {
+	char   magic[4];    // "SCC1", or "SCC2" when the offsets need 64 bits
+	int    vertexNo;
+	Offset edgeNo;
+
+	static const char *tag() { return sizeof(Offset) == sizeof(int) ? "SCC1" : "SCC2"; }
+
+	bool valid() const { return !memcmp(magic, tag(), 4) && vertexNo > 0 && edgeNo >= 0; }
+
+	size_t bytes() const {
+		return sizeof(GraphHeader) + ((size_t) vertexNo + 1) * sizeof(Offset) + (size_t) edgeNo * sizeof(int);
+	}
+};
+
+/* A graph searched in its binary form, mapped from the input or read from text into the same
+ * layout: the CSR stays where it is, and the integer view, labels and condensation are those of
+ * Graph without any Vertex or Edge object. Only the CSR engines (pearce, states, ufscc) run on it.
+ * Offset is the type of the edge offsets of the input */
+template <class O>
+class MappedGraph {
+
+	public:
+
+		typedef O Offset;   // type of the edge offsets
+
+	private:
+
+		const int            _vertexNo;
+		const Offset         _edgeNo;
+		const Offset        *_start;
+		const int           *_targets;
+		int                  _sccNo;
+		Offset               _connectNo;
+		std::vector<int>     _keys;
+		std::vector<char>    _peeled;
+		std::vector<Offset>  _condensedStart;   // condensation edges by start key, then by end
+		std::vector<int>     _condensed;
+
+	public:
+
+		MappedGraph(const char *data) :
+			_vertexNo(((const GraphHeader<Offset> *) data)->vertexNo),
+			_edgeNo(((const GraphHeader<Offset> *) data)->edgeNo),
+			_start((const Offset *) (data + sizeof(GraphHeader<Offset>))),
+			_targets((const int *) (_start + _vertexNo + 1)),
+			_sccNo(0),
+			_connectNo(0),
+			_keys(_vertexNo),
+			_peeled(_vertexNo, 0) {
+			for (int i = 0; i < _vertexNo; i++)
+				_keys[i] = i + 1;
+		}
+
+		// Integer view, as in Graph
+		int size()             const { return _vertexNo;       }
+		Offset adjStart(int i) const { return _start[i];       }
+		Offset adjEnd(int i)   const { return _start[i + 1];   }
+		int target(Offset e)   const { return _targets[e];     }
+		int original(int i)    const { return i;               }
+
+		void prefetch(int i) const { __builtin_prefetch(&_start[i]); }
+
+		// Cursor over the out-edges of vertex i, as the CSR engines walk them
+		typedef Offset Cursor;
+		Cursor cursor(int i)                  const { return adjStart(i); }
+		bool more(int i, Cursor e)            const { return e < adjEnd(i); }
+		int next(Cursor &e)                   const { return target(e++); }
+		int peek(int i, Cursor e, int ahead)  const { return e + ahead < adjEnd(i) ? target(e + ahead) : -1; }
+		void generateTargets() {}
+
+		bool peeled(int i) const     { return _peeled[i]; }
+		void label(int i, int key)   { _keys[i] = key; }
+		void peel(int i, int key)    { _peeled[i] = 1; _keys[i] = key; }
+
+		void incrementSCC() { _sccNo++; }
+
+		// Offsets increasing from 0 to E and every end in range, so the search cannot stray
+		bool check() const {
+			if (_start[0] != 0 || _start[_vertexNo] != _edgeNo)
+				return false;
+			for (int i = 0; i < _vertexNo; i++)
+				if (_start[i] > _start[i + 1])
+					return false;
+			for (Offset e = 0; e < _edgeNo; e++)
+				if (_targets[e] < 0 || _targets[e] >= _vertexNo)
+					return false;
+			return true;
+		}
+
+		/* Edges between SCCs as key pairs, bucketed by start key, each bucket sorted and
+		 * without repeats; the order and count printed by Graph */
+		void condense() {
+			_condensedStart.assign(_vertexNo + 2, 0);
+
+			for (int v = 0; v < _vertexNo; v++)
+				for (Offset e = _start[v]; e < _start[v + 1]; e++)
+					if (_keys[v] != _keys[_targets[e]])
+						_condensedStart[_keys[v] + 1]++;
+			for (int k = 1; k <= _vertexNo + 1; k++)
+				_condensedStart[k] += _condensedStart[k - 1];
+
+			std::vector<Offset> next(_condensedStart.begin(), _condensedStart.end() - 1);
+			_condensed.resize(_condensedStart[_vertexNo + 1]);
+			for (int v = 0; v < _vertexNo; v++)
+				for (Offset e = _start[v]; e < _start[v + 1]; e++)
+					if (_keys[v] != _keys[_targets[e]])
+						_condensed[next[_keys[v]]++] = _keys[_targets[e]];
+
+			// Buckets compacted in place as they are sorted
+			Offset last = 0;
+			for (int k = 1; k <= _vertexNo; k++) {
+				std::vector<int>::iterator first = _condensed.begin() + _condensedStart[k];
+				std::vector<int>::iterator end = _condensed.begin() + _condensedStart[k + 1];
+				std::sort(first, end);
+				end = std::unique(first, end);
+				_condensedStart[k] = last;
+				last = std::copy(first, end, _condensed.begin() + last) - _condensed.begin();
+			}
+			_condensedStart[_vertexNo + 1] = last;
+			_condensed.resize(last);
+			_connectNo = last;
+		}
+
+		std::vector< std::pair<std::string, size_t> > memory() const {
+			std::vector< std::pair<std::string, size_t> > usage;
+
+			usage.push_back(std::make_pair("csr", ((size_t) _vertexNo + 1) * sizeof(Offset) + (size_t) _edgeNo * sizeof(int)));
+			usage.push_back(std::make_pair("keys", _keys.capacity() * sizeof(int) + _peeled.capacity()));
+			usage.push_back(std::make_pair("condensation", _condensedStart.capacity() * sizeof(Offset) + _condensed.capacity() * sizeof(int)));
+			return usage;
+		}
+
+		void print(FILE *out = stdout) const {
+			fprintf(out, "%d\n", _sccNo);
+			fprintf(out, "%lld\n", (long long) _connectNo);
+
+			for (int k = 1; k <= _vertexNo; k++)
+				for (Offset i = _condensedStart[k]; i < _condensedStart[k + 1]; i++)
+					fprintf(out, "%d %d\n", k, _condensed[i]);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Trim
+|
+\----------------------------------------*/
+/* Peels trivial SCCs before the DFS. Trim-1 removes every vertex left with no live in-edge or no
+ * live out-edge, a singleton SCC that keeps its own key. Trim-2 removes a pair u <-> v whose only
+ * live in-edges (or only live out-edges) come from each other, an SCC of two labelled with the
+ * smaller key. Both work on degree counters updated as vertices go; the order is trim-1 to a fixed
+ * point, one trim-2 pass, trim-1 again. Peeled vertices are marked discovered, so the engines skip
+ * them */
+template <class G>
+class Trim {
+
+		G                 &_graph;
+		typedef typename G::Offset Offset;
+
+		std::vector<Offset> _in;
+		std::vector<Offset> _out;
+		std::vector<Offset> _sourceStart;   // reverse CSR: in-edges of every vertex
+		std::vector<int>    _sources;
+		std::vector<char>  _removed;
+		std::vector<int>   _queue;
+
+		void remove(int v) {
+			_removed[v] = 1;
+			for (Offset e = _graph.adjStart(v); e < _graph.adjEnd(v); e++) {
+				int w = _graph.target(e);
+				if (!_removed[w] && --_in[w] == 0)
+					_queue.push_back(w);
+			}
+			for (Offset e = _sourceStart[v]; e < _sourceStart[v + 1]; e++) {
+				int u = _sources[e];
+				if (!_removed[u] && --_out[u] == 0)
+					_queue.push_back(u);
+			}
+		}
+
+		void label(int v, int key) { _graph.peel(v, key); }
+
+		// The only live in-neighbour of v, when it has exactly one
+		int singleSource(int v) const {
+			if (_in[v] != 1)
+				return -1;
+			for (Offset e = _sourceStart[v]; e < _sourceStart[v + 1]; e++)
+				if (!_removed[_sources[e]])
+					return _sources[e];
+			return -1;
+		}
+
+		// The only live out-neighbour of v, when it has exactly one
+		int singleTarget(int v) const {
+			if (_out[v] != 1)
+				return -1;
+			for (Offset e = _graph.adjStart(v); e < _graph.adjEnd(v); e++)
+				if (!_removed[_graph.target(e)])
+					return _graph.target(e);
+			return -1;
+		}
+
+		void trim1() {
+			while (!_queue.empty()) {
+				int v = _queue.back();
+				_queue.pop_back();
+				if (_removed[v])
+					continue;
+				label(v, v + 1);
+				_graph.incrementSCC();
+				remove(v);
+			}
+		}
+
+		void trim2() {
+			for (int v = 0; v < _graph.size(); v++) {
+				if (_removed[v])
+					continue;
+
+				int u = singleSource(v);
+				if (u < 0 || u == v || singleSource(u) != v) {
+					u = singleTarget(v);
+					if (u < 0 || u == v || singleTarget(u) != v)
+						continue;
+				}
+
+				int key = std::min(u, v) + 1;
+				label(u, key);
+				label(v, key);
+				_graph.incrementSCC();
+				remove(u);
+				remove(v);
+			}
+		}
 
-		Graph               &_graph;
-		std::stack<Vertex*>  _stack;
-		int                  _index;
-		int					 _adjStart;
-		
 	public:
 
-		SCCFinder(Graph &g) :
+		Trim(G &g) :
 			_graph(g),
-			_index(0),
-			_adjStart(0) {}
+			_in(g.size(), 0),
+			_out(g.size(), 0),
+			_sourceStart(g.size() + 1, 0),
+			_removed(g.size(), 0) {}
+
+		void run() {
+			int size = _graph.size();
+
+			_graph.generateTargets();
+
+			// Counting sort of the edges by end
+			_sources.resize(_graph.adjEnd(size - 1));
+			for (int v = 0; v < size; v++) {
+				_out[v] = _graph.adjEnd(v) - _graph.adjStart(v);
+				for (Offset e = _graph.adjStart(v); e < _graph.adjEnd(v); e++)
+					_in[_graph.target(e)]++;
+			}
+			for (int v = 0; v < size; v++)
+				_sourceStart[v + 1] = _sourceStart[v] + _in[v];
+			std::vector<Offset> next(_sourceStart.begin(), _sourceStart.end() - 1);
+			for (int v = 0; v < size; v++)
+				for (Offset e = _graph.adjStart(v); e < _graph.adjEnd(v); e++)
+					_sources[next[_graph.target(e)]++] = v;
+
+			for (int v = 0; v < size; v++)
+				if (_in[v] == 0 || _out[v] == 0)
+					_queue.push_back(v);
+
+			trim1();
+			trim2();
+			trim1();
+		}
 
-		// Tarjan start and future restarts
-		void tarjan() {
-			for (Vertex *v : _graph.vertices())
-				if (v->undiscovered())
-					strongconnect(v);
+};
+
+/*---------------------------------------
+|
+|    Pearce
+|
+\----------------------------------------*/
+/* Pearce's SCC algorithm (PEA_FIND_SCC2): one rindex word and one root bit per vertex replace
+ * discovery, lowlink and onStack. While a vertex is open, rindex is its DFS index; once its SCC is
+ * done it becomes the component number, counted down from V (never reaching the 0 of unvisited
+ * vertices), so it is larger than any open index and never lowers anything again. Indices are
+ * handed back when a component completes, which keeps both ranges apart. The DFS is iterative; an
+ * SCC is a slice at the top of the stack, so its members are relabelled in place.
+ *
+ * The search runs on any adjacency with the interface of Graph: size, a Cursor over the out-edges
+ * of a vertex (cursor, more, next, and peek for the target some edges ahead, or -1), prefetch,
+ * and original(v), the graph index of its vertex v. Labels are written on the graph, Graph or
+ * MappedGraph, through peeled, label and incrementSCC.
+ *
+ * With a prefetch distance d, the edge d places ahead has the rindex and adjacency offset of its
+ * target requested from memory, and a newly opened vertex does the same for its first d edges */
+template <class G, class Adjacency>
+class Pearce {
+
+		G                  &_graph;
+		const Adjacency    &_adj;
+		std::vector<int>    _rindex;
+		std::vector<bool>   _root;
+		std::vector<int>    _stack;     // vertices of unfinished SCCs
+		std::vector<int>    _path;      // DFS path
+		std::vector<typename Adjacency::Cursor> _next;   // next edge of each vertex on the path
+		int                 _index;
+		int                 _component;
+		int                 _distance;
+
+		void prefetch(int w) {
+			if (w < 0)
+				return;
+			__builtin_prefetch(&_rindex[w]);
+			_adj.prefetch(w);
+		}
+
+		void open(int v) {
+			_rindex[v] = _index++;
+			_root[v] = true;
+			_path.push_back(v);
+			_next.push_back(_adj.cursor(v));
+
+			for (int i = 0; i < _distance; i++)
+				prefetch(_adj.peek(v, _next.back(), i));
+		}
+
+		void lower(int v, int w) {
+			if (_rindex[w] < _rindex[v]) {
+				_rindex[v] = _rindex[w];
+				_root[v] = false;
+			}
 		}
 
-		// Tarjan recursion
-		void strongconnect(Vertex *v) {
+		// v is done; as a root it closes the SCC made of itself and the stack above its rindex
+		void close(int v) {
+			if (!_root[v]) {
+				_stack.push_back(v);
+				return;
+			}
 
-			v->discovery(_index);
-			v->lowlink(_index);
-			v->onStack(true);
-			_index += 1;
-			_stack.push(v);
-			int start = _graph.adjStart(v);
-			int end   = start + _graph.adjSize(v);
+			size_t first = _stack.size();
+			int minKey = _adj.original(v) + 1;
 
+			_index--;
+			while (first > 0 && _rindex[v] <= _rindex[_stack[first - 1]]) {
+				first--;
+				_index--;
+				if (_adj.original(_stack[first]) + 1 < minKey)
+					minKey = _adj.original(_stack[first]) + 1;
+			}
 
-			for (int i = start; i < end; i++) {
+			for (size_t i = first; i < _stack.size(); i++) {
+				_rindex[_stack[i]] = _component;
+				_graph.label(_adj.original(_stack[i]), minKey);
+			}
+			_stack.resize(first);
 
-				Vertex *neighbour = _graph.edge(i)->end();
+			_rindex[v] = _component--;
+			_graph.label(_adj.original(v), minKey);
+			_graph.incrementSCC();
+		}
 
-				if (neighbour->undiscovered()) {
-					strongconnect(neighbour);
-					v->lowerlink(*neighbour);
+		void visit(int root) {
+			open(root);
+
+			while (!_path.empty()) {
+				int v = _path.back();
+				typename Adjacency::Cursor &c = _next.back();
+
+				if (_adj.more(v, c)) {
+					if (_distance > 0)
+						prefetch(_adj.peek(v, c, _distance));
+					int w = _adj.next(c);
+					if (_rindex[w] == 0)
+						open(w);
+					else
+						lower(v, w);
+					continue;
 				}
-				else if (neighbour->onStack())
-					v->lowerlink(*neighbour);
 
-				
+				_path.pop_back();
+				_next.pop_back();
+				close(v);
+				if (!_path.empty())
+					lower(_path.back(), v);
 			}
-	
-			if(v->lowlink() == v->discovery()) {
-				Vertex *w;
-				std::list<Vertex*> members;
-				int minKey = v->key();
-				_graph.incrementSCC();
-				do {
-					w = _stack.top();
-					members.push_front(w);
-					w->onStack(false);
-					_stack.pop();
-					if (w->key() < minKey)
-						minKey = w->key();
-				} while (*w != *v);
-				for (Vertex *m : members)
-					m->key(minKey);
+		}
+
+	public:
+
+		Pearce(G &g, const Adjacency &adj, int distance = 0) :
+			_graph(g),
+			_adj(adj),
+			_rindex(adj.size(), 0),
+			_root(adj.size(), false),
+			_index(1),
+			_component(adj.size()),
+			_distance(distance) {}
+
+		// Vertices peeled by Trim are already complete components
+		void run() {
+			for (int v = 0; v < _adj.size(); v++)
+				if (_graph.peeled(_adj.original(v)))
+					_rindex[v] = _component--;
+			for (int v = 0; v < _adj.size(); v++)
+				if (_rindex[v] == 0)
+					visit(v);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Reordering
+|
+\----------------------------------------*/
+/* A renumbering of the vertices and the CSR rebuilt in the new numbers, so that vertices searched
+ * together sit together in memory:
+ *  - BFS: breadth-first order over out-edges, from every vertex in turn
+ *  - degree: by decreasing out-degree
+ *  - RCM: reverse Cuthill-McKee; breadth-first from the lowest degree vertex, neighbours taken by
+ *    increasing degree, and the whole order reversed */
+enum Order { ORIGINAL, BFS_ORDER, DEGREE_ORDER, RCM_ORDER };
+
+template <class O>
+class Reordering {
+
+	public:
+
+		typedef O Offset;   // type of the edge offsets
+
+	private:
+
+		std::vector<int>    _original;   // graph index of every new index
+		std::vector<Offset> _start;
+		std::vector<int>    _targets;
+
+		template <class G>
+		void breadthFirst(const G &g, const std::vector<int> &starts, bool byDegree) {
+			std::vector<char> seen(g.size(), 0);
+			std::vector<int>  neighbours;
+
+			auto degree = [&](int v) { return (Offset) (g.adjEnd(v) - g.adjStart(v)); };
+
+			for (int s : starts) {
+				if (seen[s])
+					continue;
+				seen[s] = 1;
+				size_t head = _original.size();
+				_original.push_back(s);
+
+				for (; head < _original.size(); head++) {
+					int v = _original[head];
+					neighbours.clear();
+					for (Offset e = g.adjStart(v); e < g.adjEnd(v); e++)
+						if (!seen[g.target(e)]) {
+							seen[g.target(e)] = 1;
+							neighbours.push_back(g.target(e));
+						}
+					if (byDegree)
+						std::stable_sort(neighbours.begin(), neighbours.end(),
+							[&](int a, int b) { return degree(a) < degree(b); });
+					_original.insert(_original.end(), neighbours.begin(), neighbours.end());
+				}
 			}
-			
+		}
+
+		// Vertices by out-degree; counting sort, stable
+		template <class G>
+		static std::vector<int> byDegree(const G &g, bool decreasing) {
+			int size = g.size();
+			Offset top = 0;
+
+			for (int v = 0; v < size; v++)
+				top = std::max(top, (Offset) (g.adjEnd(v) - g.adjStart(v)));
+
+			std::vector<int> count(top + 2, 0);
+			std::vector<int> order(size);
+
+			for (int v = 0; v < size; v++) {
+				Offset d = g.adjEnd(v) - g.adjStart(v);
+				count[(decreasing ? top - d : d) + 1]++;
+			}
+			for (Offset d = 1; d <= top + 1; d++)
+				count[d] += count[d - 1];
+			for (int v = 0; v < size; v++) {
+				Offset d = g.adjEnd(v) - g.adjStart(v);
+				order[count[decreasing ? top - d : d]++] = v;
+			}
+			return order;
+		}
+
+	public:
+
+		template <class G>
+		Reordering(G &g, Order order) {
+			int size = g.size();
+
+			g.generateTargets();
+			_original.reserve(size);
+
+			switch (order) {
+				case BFS_ORDER: {
+					std::vector<int> all(size);
+					for (int v = 0; v < size; v++)
+						all[v] = v;
+					breadthFirst(g, all, false);
+					break;
+				}
+				case DEGREE_ORDER:
+					_original = byDegree(g, true);
+					break;
+				case RCM_ORDER:
+					breadthFirst(g, byDegree(g, false), true);
+					std::reverse(_original.begin(), _original.end());
+					break;
+				default:
+					for (int v = 0; v < size; v++)
+						_original.push_back(v);
+			}
+
+			std::vector<int> renamed(size);
+			for (int i = 0; i < size; i++)
+				renamed[_original[i]] = i;
+
+			_start.assign(size + 1, 0);
+			_targets.resize(g.adjEnd(size - 1));
+			for (int i = 0; i < size; i++) {
+				int v = _original[i];
+				Offset k = _start[i];
+				for (Offset e = g.adjStart(v); e < g.adjEnd(v); e++)
+					_targets[k++] = renamed[g.target(e)];
+				_start[i + 1] = k;
+			}
+		}
+
+		// A CSR already built in the new numbers; the vectors are taken, not copied
+		Reordering(std::vector<int> &original, std::vector<Offset> &start, std::vector<int> &targets) {
+			_original.swap(original);
+			_start.swap(start);
+			_targets.swap(targets);
+		}
+
+		int size()             const { return _original.size();  }
+		Offset adjStart(int v) const { return _start[v];         }
+		Offset adjEnd(int v)   const { return _start[v + 1];     }
+		int target(Offset e)   const { return _targets[e];       }
+		int original(int v)    const { return _original[v];      }
+
+		void prefetch(int v)   const { __builtin_prefetch(&_start[v]); }
+
+		// Cursor over the out-edges of vertex i, as the CSR engines walk them
+		typedef Offset Cursor;
+		Cursor cursor(int i)                  const { return adjStart(i); }
+		bool more(int i, Cursor e)            const { return e < adjEnd(i); }
+		int next(Cursor &e)                   const { return target(e++); }
+		int peek(int i, Cursor e, int ahead)  const { return e + ahead < adjEnd(i) ? target(e + ahead) : -1; }
+
+		size_t bytes() const {
+			return (_original.capacity() + _targets.capacity()) * sizeof(int) + _start.capacity() * sizeof(Offset);
 		}
 
 };
 
 /*---------------------------------------
 |
-|    main
+|    Compressed
 |
-|----------------------------------------*/
-int main() {
+\----------------------------------------*/
+/* The out-edges of every vertex sorted, without repeats, and stored as the zigzag deltas from the
+ * previous target (the first one from the vertex itself) in byte-aligned varints of 7 bits per
+ * byte. Local graphs take one or two bytes per edge instead of four; the CSR engine decodes the
+ * deltas as it walks them, so targets ahead are not known and peek never prefetches. Offset is the
+ * type of the byte offsets, that of the edge offsets of the CSR it is built from */
+template <class O>
+class Compressed {
 
-	int vertexNo;
-	int edgeNo;
+	public:
 
-	int edgeStart;
-	int edgeEnd;
+		typedef O Offset;   // type of the byte offsets
 
-	// Reading input; creation of objects
-	fscanf(stdin, "%d", &vertexNo);
-	fscanf(stdin, "%d", &edgeNo);
+	private:
 
-	Graph g(vertexNo, edgeNo);
-	SCCFinder finder(g);
+		std::vector<Offset>         _start;      // byte offset of every list
+		std::vector<unsigned char>  _bytes;
+		std::vector<int>            _original;   // empty when built on the graph order
 
-	for (int i = 1; i <= vertexNo; i++)
-		g.addVertex(new Vertex(i));
+		void put(int delta) {
+			unsigned value = ((unsigned) delta << 1) ^ (unsigned) (delta >> 31);
+			while (value >= 0x80) {
+				_bytes.push_back((unsigned char) (value | 0x80));
+				value >>= 7;
+			}
+			_bytes.push_back((unsigned char) value);
+		}
 
-	for(int i = 0; i < edgeNo; i++) {
-		fscanf(stdin, "%d %d", &edgeStart, &edgeEnd); 
-		g.addEdge(new Edge(g.vertex(edgeStart), g.vertex(edgeEnd)), i);
-	}
+	public:
 
-	// Main procedure
-	g.sortByStart();
-	g.generateAdjacency();
-	finder.tarjan();
-	g.sortByEnd();
-	g.sortByStart();
-	g.connectionsNumber();
-	g.print();
+		struct Cursor {
+			Offset byte;
+			int    last;
+		};
+
+		// From any CSR with the integer view of Graph
+		template <class A>
+		Compressed(const A &adj) :
+			_start(adj.size() + 1, 0) {
+			int size = adj.size();
+			std::vector<int> list;
+
+			for (int v = 0; v < size; v++)
+				if (adj.original(v) != v) {
+					_original.resize(size);
+					for (int i = 0; i < size; i++)
+						_original[i] = adj.original(i);
+					break;
+				}
 
-	// Deletion of objects
-	for (int i = 0; i < edgeNo; i++)
-		delete g.edge(i);
+			_bytes.reserve((size_t) adj.adjEnd(size - 1) + size);
+			for (int v = 0; v < size; v++) {
+				list.assign(adj.adjEnd(v) - adj.adjStart(v), 0);
+				for (typename A::Offset e = adj.adjStart(v); e < adj.adjEnd(v); e++)
+					list[e - adj.adjStart(v)] = adj.target(e);
+				std::sort(list.begin(), list.end());
+				list.erase(std::unique(list.begin(), list.end()), list.end());
+
+				int last = v;
+				for (int w : list) {
+					put(w - last);
+					last = w;
+				}
+				// Up to five bytes an edge, so the bytes may outgrow offsets that hold the edges
+				if (_bytes.size() > (size_t) std::numeric_limits<Offset>::max())
+					throw std::runtime_error("compressed lists too long for 32-bit offsets; convert the input with -l");
+				_start[v + 1] = _bytes.size();
+			}
+			_bytes.shrink_to_fit();
+		}
+
+		int size()          const { return _start.size() - 1; }
+		int original(int v) const { return _original.empty() ? v : _original[v]; }
+
+		void prefetch(int v) const { __builtin_prefetch(&_start[v]); }
+
+		Cursor cursor(int v) const {
+			Cursor c = { _start[v], v };
+			return c;
+		}
+
+		bool more(int v, const Cursor &c) const { return c.byte < _start[v + 1]; }
+
+		int next(Cursor &c) const {
+			unsigned value = 0;
+			int shift = 0;
+			unsigned char b;
+
+			do {
+				b = _bytes[c.byte++];
+				value |= (unsigned) (b & 0x7F) << shift;
+				shift += 7;
+			} while (b & 0x80);
+
+			c.last += (int) (value >> 1) ^ -(int) (value & 1);
+			return c.last;
+		}
+
+		int peek(int, const Cursor &, int) const { return -1; }
+
+		size_t bytes() const {
+			return _start.capacity() * sizeof(Offset) + _bytes.capacity() + _original.capacity() * sizeof(int);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    StateSpace
+|
+\----------------------------------------*/
+/* How a search numbers the states it finds, in the order it finds them: a hash table from state to
+ * number, for states of any type with equality and a hash */
+template <class State, class Hash = std::hash<State> >
+class HashNumbering {
+
+		std::unordered_map<State, int, Hash>  _numbers;
+		std::vector<const State *>            _states;      // keys of _numbers, by number
+
+	public:
+
+		template <class Space>
+		HashNumbering(const Space &) {}
+
+		// -1 for a state not found yet
+		int find(const State &s) const {
+			typename std::unordered_map<State, int, Hash>::const_iterator found = _numbers.find(s);
+			return found == _numbers.end() ? -1 : found->second;
+		}
+
+		void add(const State &s) {
+			int n = _states.size();
+			_states.push_back(&_numbers.emplace(s, n).first->first);
+		}
+
+		const State &state(int n) const { return *_states[n]; }
+
+};
+
+/* The same for spaces whose states are already the ints 0 .. size() - 1, as the vertices of an
+ * explicit graph: two vectors and no hashing */
+class DenseNumbering {
+
+		std::vector<int> _numbers;    // by state, -1 for one not found yet
+		std::vector<int> _states;     // by number
+
+	public:
+
+		template <class Space>
+		DenseNumbering(const Space &space) :
+			_numbers(space.size(), -1) {}
+
+		int find(int s) const { return _numbers[s]; }
+
+		void add(int s) {
+			_numbers[s] = _states.size();
+			_states.push_back(s);
+		}
+
+		const int &state(int n) const { return _states[n]; }
+
+};
+
+/* Tarjan's SCC algorithm on a graph that is never built: vertices are states of any type, found
+ * through a successor function as the search reaches them. A Space provides
+ *  - State, copyable, with equality and a hash (Hash, std::hash by default)
+ *  - successors(s, out), appending the successors of s to out
+ * States are numbered as they are found, so a state's number is its discovery index; Numbering
+ * maps states to numbers and everything else is a vector by number. The DFS is iterative, with
+ * the pending successors of the whole path on one stack.
+ *
+ * This is the one Tarjan of the program: tarjan and states run it on explicit graphs, with the
+ * vertices as states, and Dynamic on the members of one component.
+ *
+ * With stopAtCycle, the search ends at the first SCC with a cycle (more than one state, or a
+ * self-loop), whose states are then in cycle(); the search cannot be resumed after that */
+template <class Space, class Numbering = HashNumbering<typename Space::State> >
+class StateSpace {
+
+		typedef typename Space::State State;
+
+		struct Frame {
+			int    state;
+			size_t next;    // next pending successor
+			size_t end;     // past the last one; those of the next frame follow
+			bool   loop;    // an edge back to the state itself was seen
+		};
+
+		const Space                          &_space;
+		bool                                  _stopAtCycle;
+		Numbering                             _numbering;
+		int                                   _size;
+		std::vector<int>                      _lowlink;
+		std::vector<int>                      _component;   // -1 while on the stack
+		std::vector<int>                      _stack;
+		std::vector<Frame>                    _path;
+		std::vector<State>                    _pending;     // successors not yet taken
+		std::vector<State>                    _cycle;
+		int                                   _sccNo;
+
+		void open(const State &s) {
+			int n = _size++;
+			_numbering.add(s);
+			_lowlink.push_back(n);
+			_component.push_back(-1);
+			_stack.push_back(n);
+
+			Frame f = { n, _pending.size(), 0, false };
+			_space.successors(s, _pending);
+			f.end = _pending.size();
+			_path.push_back(f);
+		}
+
+		// v is done; false when its SCC has a cycle and the search stops there
+		bool close(const Frame &f) {
+			int v = f.state;
+
+			if (_lowlink[v] != v)
+				return true;
+
+			size_t first = _stack.size() - 1;
+			while (_stack[first] != v)
+				first--;
+			for (size_t i = first; i < _stack.size(); i++)
+				_component[_stack[i]] = _sccNo;
+			_sccNo++;
+
+			if (_stopAtCycle && (f.loop || first + 1 < _stack.size())) {
+				for (size_t i = first; i < _stack.size(); i++)
+					_cycle.push_back(_numbering.state(_stack[i]));
+				_stack.resize(first);
+				return false;
+			}
+			_stack.resize(first);
+			return true;
+		}
+
+	public:
+
+		StateSpace(const Space &space, bool stopAtCycle = false) :
+			_space(space),
+			_stopAtCycle(stopAtCycle),
+			_numbering(space),
+			_size(0),
+			_sccNo(0) {}
+
+		/* Every state reachable from initial that no earlier run found; false when it stopped
+		 * at a cycle */
+		bool run(const State &initial) {
+			if (!_cycle.empty())
+				return false;
+			if (_numbering.find(initial) >= 0)
+				return true;
+
+			open(initial);
+			while (!_path.empty()) {
+				Frame &f = _path.back();
+				int v = f.state;
+
+				if (f.next < f.end) {
+					State w = _pending[f.next++];
+					int found = _numbering.find(w);
+
+					if (found < 0)
+						open(w);
+					else if (found == v)
+						f.loop = true;
+					else if (_component[found] < 0)
+						_lowlink[v] = std::min(_lowlink[v], found);
+					continue;
+				}
+
+				Frame done = f;
+				_path.pop_back();
+				_pending.resize(_path.empty() ? 0 : _path.back().end);
+				if (!close(done))
+					return false;
+				if (!_path.empty())
+					_lowlink[_path.back().state] = std::min(_lowlink[_path.back().state], _lowlink[v]);
+			}
+			return true;
+		}
+
+		int size()                     const { return _size;                }
+		int components()               const { return _sccNo;               }
+		const State &state(int n)      const { return _numbering.state(n);  }
+		int component(int n)           const { return _component[n];        }
+		const std::vector<State> &cycle() const { return _cycle;            }
+
+		// -1 for a state never found
+		int number(const State &s) const { return _numbering.find(s); }
+
+};
+
+/* The state space search on several threads at once, after UFSCC (Bloemen, Laarman and van de
+ * Pol): every worker runs its own DFS from the same states, taking successors in its own random
+ * order, and the SCCs are a union-find shared by all. When a worker meets a state of a set on its
+ * own stack, every set above that one is united with it, as Tarjan pops its stack; the sets on a
+ * worker's stack are those carrying its bit. A set lists its states not yet fully explored, and
+ * any worker holding the set takes its next state from there, so the workers share the search
+ * of a large SCC. A set whose list empties is a complete SCC and is marked dead, and nobody
+ * enters it again.
+ *
+ * States are found through a hash table split in shards, each behind its own lock; the union-find
+ * nodes live in blocks that never move. Finds are lock-free with path halving; a union, a claim
+ * that changes a worker set and any use of a list lock the roots involved. successors is called
+ * by all workers at once. At most 64 workers */
+template <class Space, class Hash = std::hash<typename Space::State> >
+class ParallelStateSpace {
+
+		typedef typename Space::State State;
+
+		static const int Shards = 1024;
+		static const int BlockBits = 16;
+		static const int Blocks = 1 << 15;
+
+		enum Claim { CLAIM_NEW, CLAIM_SUCCESS, CLAIM_FOUND, CLAIM_DEAD };
+
+		struct Node {
+			std::atomic<int>                 next;      // cyclic list of the states of the set
+			std::atomic<int>                 head;      // on a root, first state of its list, -1 once empty
+			std::atomic<unsigned long long>  workers;   // on a root, workers with the set on their stack
+			std::atomic<char>                done;      // every successor taken
+			std::atomic<char>                dead;      // on a root, the SCC is complete
+			std::atomic<char>                lock;
+			const State                     *state;
+		};
+
+		// Parents apart from the rest, as finds go through nothing else
+		struct Block {
+			std::atomic<int>  parent[1 << BlockBits];
+			Node              nodes[1 << BlockBits];
+		};
+
+		struct Shard {
+			std::mutex                            lock;
+			std::unordered_map<State, int, Hash>  numbers;
+		};
+
+		struct Frame {
+			int    state;
+			int    current;   // state of the set being explored, -1 before the first
+			size_t next;      // next pending successor of current
+			size_t end;
+		};
+
+		const Space             &_space;
+		int                      _threads;
+		std::vector<Shard>       _shards;
+		std::atomic<Block *>     _blocks[Blocks];
+		std::atomic<int>         _size;
+		std::mutex               _grow;
+		std::vector<int>         _component;
+		int                      _sccNo;
+
+		Block &block(int n)           const { return *_blocks[n >> BlockBits].load(std::memory_order_acquire); }
+		Node &node(int n)             const { return block(n).nodes[n & ((1 << BlockBits) - 1)];  }
+		std::atomic<int> &parent(int n) const { return block(n).parent[n & ((1 << BlockBits) - 1)]; }
+
+		int find(int n) {
+			for (;;) {
+				int p = parent(n).load(std::memory_order_acquire);
+				if (p == n)
+					return n;
+				int g = parent(p).load(std::memory_order_acquire);
+				if (g != p)
+					parent(n).compare_exchange_weak(p, g);
+				n = p;
+			}
+		}
+
+		void lock(int n) {
+			while (node(n).lock.exchange(1, std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+
+		void unlock(int n) { node(n).lock.store(0, std::memory_order_release); }
+
+		// Root of n, locked and still a root
+		int lockRoot(int n) {
+			for (;;) {
+				int r = find(n);
+				lock(r);
+				if (parent(r).load(std::memory_order_acquire) == r)
+					return r;
+				unlock(r);
+			}
+		}
+
+		bool sameSet(int a, int b) {
+			for (;;) {
+				int ra = find(a);
+				int rb = find(b);
+				if (ra == rb)
+					return true;
+				if (parent(ra).load(std::memory_order_acquire) == ra)
+					return false;
+			}
+		}
+
+		// The set of b joins that of a; lists are spliced, worker sets merged
+		void unite(int a, int b) {
+			for (;;) {
+				int ra = find(a);
+				int rb = find(b);
+				if (ra == rb)
+					return;
+				lock(std::min(ra, rb));
+				lock(std::max(ra, rb));
+				if (parent(ra).load() != ra || parent(rb).load() != rb) {
+					unlock(std::max(ra, rb));
+					unlock(std::min(ra, rb));
+					continue;
+				}
 
-	for (int i = 1; i <= vertexNo; i++)
-		delete g.vertex(i);
+				int root = std::min(ra, rb);
+				int other = std::max(ra, rb);
+				parent(other).store(root, std::memory_order_release);
+				node(root).workers.fetch_or(node(other).workers.load());
+
+				int h = node(root).head.load();
+				int o = node(other).head.load();
+				if (o >= 0) {
+					if (h < 0)
+						node(root).head.store(o);
+					else {
+						int next = node(h).next.load();
+						node(h).next.store(node(o).next.load());
+						node(o).next.store(next);
+					}
+				}
+
+				unlock(other);
+				unlock(root);
+				return;
+			}
+		}
+
+		/* A state of the set of n not fully explored, or -1. Done states are dropped from the
+		 * list as they are passed over; a done head only moves the head on, and goes once it
+		 * is met after another head */
+		int pick(int n) {
+			int r = lockRoot(n);
+			int found = -1;
+
+			for (;;) {
+				int h = node(r).head.load();
+				if (h < 0)
+					break;
+				if (!node(h).done.load()) {
+					found = h;
+					break;
+				}
+				int next = node(h).next.load();
+				if (next == h) {
+					node(r).head.store(-1);
+					break;
+				}
+				if (node(next).done.load()) {
+					node(h).next.store(node(next).next.load());
+					continue;
+				}
+				node(r).head.store(next);
+				found = next;
+				break;
+			}
+			unlock(r);
+			return found;
+		}
+
+		// The number of s, which is new for the worker unless dead or already on its stack
+		Claim claim(const State &s, int worker, int &n) {
+			unsigned long long bit = 1ULL << worker;
+			Shard &shard = _shards[Hash()(s) % Shards];
+
+			{
+				std::lock_guard<std::mutex> guard(shard.lock);
+				typename std::unordered_map<State, int, Hash>::iterator found = shard.numbers.find(s);
+				if (found == shard.numbers.end()) {
+					n = create();
+					found = shard.numbers.emplace(s, n).first;
+					Node &v = node(n);
+					v.state = &found->first;
+					v.workers.store(bit);
+					parent(n).store(n, std::memory_order_release);
+					return CLAIM_NEW;
+				}
+				n = found->second;
+			}
+
+			int r = find(n);
+			if (node(r).dead.load(std::memory_order_acquire))
+				return CLAIM_DEAD;
+			if (node(r).workers.load() & bit)
+				return CLAIM_FOUND;
+
+			r = lockRoot(n);
+			Claim result = CLAIM_SUCCESS;
+			if (node(r).dead.load())
+				result = CLAIM_DEAD;
+			else if (node(r).workers.load() & bit)
+				result = CLAIM_FOUND;
+			else
+				node(r).workers.fetch_or(bit);
+			unlock(r);
+			return result;
+		}
+
+		// A fresh node, alone in its set and in its list
+		int create() {
+			int n = _size++;
+			int block = n >> BlockBits;
+
+			if (_blocks[block].load(std::memory_order_acquire) == NULL) {
+				std::lock_guard<std::mutex> guard(_grow);
+				if (_blocks[block].load() == NULL)
+					_blocks[block].store(new Block, std::memory_order_release);
+			}
+
+			Node &v = node(n);
+			v.next.store(n);
+			v.head.store(n);
+			v.done.store(0);
+			v.dead.store(0);
+			v.lock.store(0);
+			return n;
+		}
+
+		void markDead(int n) {
+			int r = lockRoot(n);
+			node(r).dead.store(1, std::memory_order_release);
+			unlock(r);
+		}
+
+		// One worker's DFS from initial; R holds the sets of its stack, one state of each
+		void search(const State &initial, int worker, std::minstd_rand &random, std::vector<Frame> &path,
+			std::vector<State> &pending, std::vector<int> &roots) {
+			int n;
+
+			if (claim(initial, worker, n) == CLAIM_DEAD)
+				return;
+			Frame first = { n, -1, 0, 0 };
+			path.push_back(first);
+			roots.push_back(n);
+
+			while (!path.empty()) {
+				Frame &f = path.back();
+				int v = f.state;
+
+				if (f.next == f.end) {
+					if (f.current >= 0)
+						node(f.current).done.store(1);
+					pending.resize(path.size() > 1 ? path[path.size() - 2].end : 0);
+
+					f.current = pick(v);
+					if (f.current < 0) {
+						if (roots.back() == v) {
+							markDead(v);
+							roots.pop_back();
+						}
+						path.pop_back();
+						continue;
+					}
+
+					f.next = pending.size();
+					_space.successors(*node(f.current).state, pending);
+					f.end = pending.size();
+					for (size_t i = f.end; i > f.next + 1; i--)
+						std::swap(pending[i - 1], pending[f.next + random() % (i - f.next)]);
+					continue;
+				}
+
+				State w = pending[f.next++];
+				switch (claim(w, worker, n)) {
+					case CLAIM_NEW:
+					case CLAIM_SUCCESS: {
+						Frame next = { n, -1, pending.size(), pending.size() };
+						path.push_back(next);
+						roots.push_back(n);
+						break;
+					}
+					case CLAIM_FOUND:
+						while (!sameSet(v, n)) {
+							int r = roots.back();
+							roots.pop_back();
+							unite(roots.back(), r);
+						}
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+	public:
+
+		// threads <= 0 uses every core
+		ParallelStateSpace(const Space &space, int threads = 0) :
+			_space(space),
+			_threads(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency())),
+			_shards(Shards),
+			_size(0),
+			_sccNo(0) {
+			_threads = std::min(_threads, 64);
+			for (int b = 0; b < Blocks; b++)
+				_blocks[b].store(NULL);
+		}
+
+		~ParallelStateSpace() {
+			for (int b = 0; b < Blocks; b++)
+				delete _blocks[b].load();
+		}
+
+		/* Every state reachable from the initial ones; each worker goes through them from its
+		 * own place in the list, and components are numbered once all are done */
+		void run(const std::vector<State> &initial) {
+			std::vector<std::thread> workers;
+
+			auto work = [&](int worker) {
+				std::minstd_rand random(worker + 1);
+				std::vector<Frame> path;
+				std::vector<State> pending;
+				std::vector<int>   roots;
+				size_t size = initial.size();
+				size_t offset = size * worker / _threads;
+
+				for (size_t i = 0; i < size; i++)
+					search(initial[(offset + i) % size], worker, random, path, pending, roots);
+			};
+
+			for (int i = 1; i < _threads; i++)
+				workers.push_back(std::thread(work, i));
+			work(0);
+			for (std::thread &t : workers)
+				t.join();
+
+			_component.assign(size(), -1);
+			std::vector<int> number(size(), -1);
+			for (int n = 0; n < size(); n++) {
+				int r = find(n);
+				if (number[r] < 0)
+					number[r] = _sccNo++;
+				_component[n] = number[r];
+			}
+		}
+
+		int size()                const { return _size.load();     }
+		int components()          const { return _sccNo;           }
+		const State &state(int n) const { return *node(n).state;   }
+		int component(int n)      const { return _component[n];    }
+
+};
+
+/* Any CSR with the Cursor interface as a Space, so that explicit graphs go through the same
+ * search; vertices already peeled by Trim are left out, as complete components */
+template <class G, class Adjacency>
+class CSRSpace {
+
+		const G         &_graph;
+		const Adjacency &_adj;
+
+		// Components of a finished search as labels on the graph, keys as the other engines give them
+		template <class Search>
+		static void apply(G &g, const Adjacency &adj, const Search &search) {
+			std::vector<int> minKey(search.components(), INT_MAX);
+			for (int n = 0; n < search.size(); n++) {
+				int c = search.component(n);
+				minKey[c] = std::min(minKey[c], adj.original(search.state(n)) + 1);
+			}
+			for (int n = 0; n < search.size(); n++)
+				g.label(adj.original(search.state(n)), minKey[search.component(n)]);
+			for (int c = 0; c < search.components(); c++)
+				g.incrementSCC();
+		}
+
+	public:
+
+		typedef int State;
+
+		CSRSpace(const G &g, const Adjacency &adj) :
+			_graph(g),
+			_adj(adj) {}
+
+		int size() const { return _adj.size(); }
+
+		void successors(int v, std::vector<int> &out) const {
+			for (typename Adjacency::Cursor c = _adj.cursor(v); _adj.more(v, c);) {
+				int w = _adj.next(c);
+				if (!_graph.peeled(_adj.original(w)))
+					out.push_back(w);
+			}
+		}
+
+		// The sequential search with the states numbered by vertex rather than hashed
+		static void tarjan(G &g, const Adjacency &adj) {
+			CSRSpace space(g, adj);
+			StateSpace<CSRSpace, DenseNumbering> search(space);
+
+			for (int v = 0; v < adj.size(); v++)
+				if (!g.peeled(adj.original(v)))
+					search.run(v);
+			apply(g, adj, search);
+		}
+
+		/* Searches from every vertex and labels the graph; with threads >= 0 the parallel
+		 * search runs, on every core for 0 */
+		static void label(G &g, const Adjacency &adj, int threads = -1) {
+			CSRSpace space(g, adj);
+			std::vector<int> initial;
+
+			for (int v = 0; v < adj.size(); v++)
+				if (!g.peeled(adj.original(v)))
+					initial.push_back(v);
+
+			if (threads < 0) {
+				StateSpace<CSRSpace> search(space);
+				for (int v : initial)
+					search.run(v);
+				apply(g, adj, search);
+			}
+			else {
+				ParallelStateSpace<CSRSpace> search(space, threads);
+				search.run(initial);
+				apply(g, adj, search);
+			}
+		}
+};
+
+/*---------------------------------------
+|
+|    SCCFinder
+|
+\----------------------------------------*/
+enum Engine { TARJAN, PEARCE, STATES, UFSCC };
+
+/* The Edge objects of a Graph with the Cursor interface, so that tarjan walks them: vertex i is
+ * the one created with key i + 1 and its edges are those sorted under it, each end read through
+ * its object. The keys are read before any relabelling but Trim's: a vertex peeled with the key
+ * of its partner in a 2-cycle leads to that partner, peeled as well, and so skipped all the same.
+ *
+ * With a prefetch distance d, the edge object 2d edges ahead and the end vertex d edges ahead
+ * are requested, so that neither of the two dependent loads of an edge waits on memory when its
+ * turn comes; a cursor requests the first edges of its vertex, which nothing looks ahead to */
+class Objects {
+
+		Graph &_graph;
+		int    _distance;
+
+	public:
+
+		typedef int Cursor;
+
+		Objects(Graph &g, int distance = 0) :
+			_graph(g),
+			_distance(distance) {}
+
+		int size()          const { return _graph.size(); }
+		int original(int i) const { return i;             }
+
+		Cursor cursor(int i) const {
+			int start = _graph.adjStart(i);
+			int end = _graph.adjEnd(i);
+
+			if (_distance > 0) {
+				for (int e = start; e < std::min(start + 2 * _distance, end); e++)
+					__builtin_prefetch(_graph.edge(e));
+				for (int e = start; e < std::min(start + _distance, end); e++)
+					__builtin_prefetch(_graph.edge(e)->end());
+			}
+			return start;
+		}
+
+		bool more(int i, Cursor e) const { return e < _graph.adjEnd(i); }
+
+		// Edges ahead past the last vertex's are left alone; past this vertex's they are the next ones
+		int next(Cursor &e) const {
+			if (_distance > 0) {
+				int end = _graph.adjEnd(_graph.size() - 1);
+				if (e + 2 * _distance < end)
+					__builtin_prefetch(_graph.edge(e + 2 * _distance));
+				if (e + _distance < end)
+					__builtin_prefetch(_graph.edge(e + _distance)->end());
+			}
+			return _graph.edge(e++)->end()->key() - 1;
+		}
+
+};
+
+class SCCFinder {
+
+		Graph                &_graph;
+		Engine               _engine;
+		Reordering<int>      *_reordering;
+		Compressed<int>      *_compressed;
+		int                   _distance;    // prefetch distance in edges; 0 turns it off
+		int                   _threads;     // workers of ufscc; 0 uses every core
+
+	public:
+
+		SCCFinder(Graph &g, Engine engine = TARJAN, int distance = 0, int threads = 0) :
+			_graph(g),
+			_engine(engine),
+			_reordering(NULL),
+			_compressed(NULL),
+			_distance(distance),
+			_threads(threads) {}
+
+		~SCCFinder() {
+			delete _reordering;
+			delete _compressed;
+		}
+
+		void run() {
+			switch (_engine) {
+				case PEARCE:
+					pearce();
+					break;
+				case STATES:
+				case UFSCC:
+					states();
+					break;
+				default:
+					tarjan();
+			}
+		}
+
+		// On the renumbered CSR when there is one
+		void pearce() {
+			_graph.generateTargets();
+			if (_compressed != NULL) {
+				Pearce<Graph, Compressed<int> > p(_graph, *_compressed, _distance);
+				p.run();
+			}
+			else if (_reordering != NULL) {
+				Pearce<Graph, Reordering<int> > p(_graph, *_reordering, _distance);
+				p.run();
+			}
+			else {
+				Pearce<Graph, Graph> p(_graph, _graph, _distance);
+				p.run();
+			}
+		}
+
+		// The state space search, on the CSR through its successors; parallel for ufscc
+		void states() {
+			int threads = _engine == UFSCC ? _threads : -1;
+
+			_graph.generateTargets();
+			if (_compressed != NULL)
+				CSRSpace<Graph, Compressed<int> >::label(_graph, *_compressed, threads);
+			else if (_reordering != NULL)
+				CSRSpace<Graph, Reordering<int> >::label(_graph, *_reordering, threads);
+			else
+				CSRSpace<Graph, Graph>::label(_graph, _graph, threads);
+		}
+
+		// Optional, before run; only CSR engines (pearce, states) search the renumbered graph
+		void reorder(Order order) {
+			delete _reordering;
+			_reordering = new Reordering<int>(_graph, order);
+		}
+
+		// Optional, before run and after any reorder, which it replaces; CSR engines only
+		void compress() {
+			_graph.generateTargets();
+			delete _compressed;
+			if (_reordering != NULL)
+				_compressed = new Compressed<int>(*_reordering);
+			else
+				_compressed = new Compressed<int>(_graph);
+			delete _reordering;
+			_reordering = NULL;
+		}
+
+		size_t reorderingBytes() const { return _reordering != NULL ? _reordering->bytes() : 0; }
+		size_t compressedBytes() const { return _compressed != NULL ? _compressed->bytes() : 0; }
+
+		// Optional, before run
+		void trim() {
+			Trim<Graph> t(_graph);
+			t.run();
+		}
+
+		// The search of the states engine, on the Edge objects, with the states numbered by vertex
+		void tarjan() {
+			Objects objects(_graph, _distance);
+			CSRSpace<Graph, Objects>::tarjan(_graph, objects);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Dynamic
+|
+\----------------------------------------*/
+/* SCCs of a labelled Graph kept up to date as edges come and go. Insertions follow Pearce and
+ * Kelly: the components hold a topological order, and an edge against it searches forward from
+ * its end and backward from its start, among the components ordered between the two only. When
+ * the forward search reaches the start, the components met by both searches are on a new cycle
+ * and merge into the one with the smallest key. The other components met move around it, into
+ * the positions the searches freed, backward ones first.
+ *
+ * Deleting an edge inside a component first looks for another path from its start to its end,
+ * within the component; any path through the edge can take that one instead, so the component
+ * holds when there is one. Otherwise Tarjan runs again on the members of that component alone.
+ * If it splits, the parts share its slice of the order, sinks last, and only the connections of
+ * its members are taken again. Every component owns the positions from its order up to its
+ * width, so the parts of a split always fit; the whole order is spread out again when a slice
+ * gets too thin.
+ *
+ * The condensation is a map per component from the key of each other end to the number of edges,
+ * both ways, so a change only touches the connections of the components it changes */
+class Dynamic {
+
+		Graph                             &_graph;
+		std::vector< std::vector<int> >    _successors;    // by vertex index, inserted edges too
+		std::vector< std::vector<int> >    _predecessors;
+		std::vector< std::vector<int> >    _members;       // vertex indices of every component, by key
+		std::vector< std::map<int, int> >  _out;           // edges to other components, by key
+		std::vector< std::map<int, int> >  _in;            // edges from other components, by key
+		std::vector<long long>             _order;         // topological position, by key
+		std::vector<long long>             _width;         // positions owned from there on
+		std::vector<int>                   _forward;       // last search that met a key going forward
+		std::vector<int>                   _backward;      // and backward
+		std::vector<int>                   _visited;       // last search that met a vertex, by index
+		int                                _search;
+		long long                          _span;          // width of every component when spread out
+
+		int component(int i) { return _graph.vertex(i + 1)->key(); }
+
+		// count more edges from component a to b; true when they are the first
+		bool link(int a, int b, int count) {
+			int &n = _out[a][b];
+			n += count;
+			_in[b][a] += count;
+			return n == count;
+		}
+
+		// One edge less from component a to b; true when it was the last
+		bool unlink(int a, int b) {
+			std::map<int, int>::iterator e = _out[a].find(b);
+			if (--e->second > 0) {
+				_in[b][a]--;
+				return false;
+			}
+			_out[a].erase(e);
+			_in[b].erase(a);
+			return true;
+		}
+
+		// One occurrence of i out of list, in any order; false when there is none
+		static bool drop(std::vector<int> &list, int i) {
+			std::vector<int>::iterator e = std::find(list.begin(), list.end(), i);
+			if (e == list.end())
+				return false;
+			*e = list.back();
+			list.pop_back();
+			return true;
+		}
+
+		// Every component the same width again, in the same order
+		void spread() {
+			std::vector<int> keys;
+
+			for (int k = 1; k <= _graph.size(); k++)
+				if (!_members[k].empty())
+					keys.push_back(k);
+			std::sort(keys.begin(), keys.end(), [&](int x, int y) { return _order[x] < _order[y]; });
+			for (size_t i = 0; i < keys.size(); i++) {
+				_order[keys[i]] = i * _span;
+				_width[keys[i]] = _span;
+			}
+		}
+
+		// Components reachable from key along edges, in positions up to upper
+		void reach(int key, long long upper, std::vector<int> &found) {
+			std::vector<int> stack(1, key);
+
+			_forward[key] = _search;
+			while (!stack.empty()) {
+				int k = stack.back();
+				stack.pop_back();
+				found.push_back(k);
+				for (const std::pair<const int, int> &e : _out[k])
+					if (_forward[e.first] != _search && _order[e.first] <= upper) {
+						_forward[e.first] = _search;
+						stack.push_back(e.first);
+					}
+			}
+		}
+
+		// Components reaching key, in positions from lower
+		void reachBack(int key, long long lower, std::vector<int> &found) {
+			std::vector<int> stack(1, key);
+
+			_backward[key] = _search;
+			while (!stack.empty()) {
+				int k = stack.back();
+				stack.pop_back();
+				found.push_back(k);
+				for (const std::pair<const int, int> &e : _in[k])
+					if (_backward[e.first] != _search && _order[e.first] >= lower) {
+						_backward[e.first] = _search;
+						stack.push_back(e.first);
+					}
+			}
+		}
+
+		bool onCycle(int key) const { return _forward[key] == _search && _backward[key] == _search; }
+
+		// The components met by both searches become one; returns its key
+		int merge(const std::vector<int> &cycle) {
+			int key = *std::min_element(cycle.begin(), cycle.end());
+
+			for (int k : cycle)
+				for (std::map<int, int>::iterator e = _out[k].begin(); e != _out[k].end(); ) {
+					if (!onCycle(e->first)) {
+						++e;
+						continue;
+					}
+					_in[e->first].erase(k);
+					e = _out[k].erase(e);
+					_graph.changeConnect(-1);
+				}
+
+			for (int k : cycle) {
+				if (k == key)
+					continue;
+				for (const std::pair<const int, int> &e : _out[k]) {
+					_in[e.first].erase(k);
+					if (!link(key, e.first, e.second))
+						_graph.changeConnect(-1);
+				}
+				for (const std::pair<const int, int> &e : _in[k]) {
+					_out[e.first].erase(k);
+					if (!link(e.first, key, e.second))
+						_graph.changeConnect(-1);
+				}
+				_out[k].clear();
+				_in[k].clear();
+
+				for (int i : _members[k]) {
+					_graph.label(i, key);
+					_members[key].push_back(i);
+				}
+				std::vector<int>().swap(_members[k]);
+			}
+
+			_graph.changeSCC(1 - (int) cycle.size());
+			return key;
+		}
+
+		/* A path from vertex index from to to, inside component key; breadth first, as the
+		 * other way round an edge is most often a short one, and ends as soon as it finds it */
+		bool reaches(int key, int from, int to) {
+			std::vector<int> queue(1, from);
+
+			_search++;
+			_visited[from] = _search;
+			for (size_t next = 0; next < queue.size(); next++)
+				for (int j : _successors[queue[next]]) {
+					if (j == to)
+						return true;
+					if (_visited[j] != _search && component(j) == key) {
+						_visited[j] = _search;
+						queue.push_back(j);
+					}
+				}
+			return false;
+		}
+
+		// The members of one component as a Space, with the edges between them only
+		class Members {
+
+				Graph                                 &_graph;
+				const std::vector< std::vector<int> > &_successors;
+				int                                    _key;
+
+			public:
+
+				typedef int State;
+
+				Members(Graph &g, const std::vector< std::vector<int> > &successors, int key) :
+					_graph(g),
+					_successors(successors),
+					_key(key) {}
+
+				void successors(int i, std::vector<int> &out) const {
+					for (int j : _successors[i])
+						if (_graph.vertex(j + 1)->key() == _key)
+							out.push_back(j);
+				}
+
+		};
+
+		/* Tarjan's algorithm on the members of component key alone, hashed so that the cost
+		 * stays with the component; the SCCs come out sinks first */
+		void split(int key, std::vector< std::vector<int> > &parts) {
+			Members space(_graph, _successors, key);
+			StateSpace<Members> search(space);
+
+			for (int i : _members[key])
+				search.run(i);
+			parts.assign(search.components(), std::vector<int>());
+			for (int n = 0; n < search.size(); n++)
+				parts[search.component(n)].push_back(search.state(n));
+		}
+
+	public:
+
+		/* On a graph labelled by any engine, with its targets generated before the labels; the
+		 * condensation is taken from them */
+		Dynamic(Graph &g) :
+			_graph(g),
+			_successors(g.size()),
+			_predecessors(g.size()),
+			_members(g.size() + 1),
+			_out(g.size() + 1),
+			_in(g.size() + 1),
+			_order(g.size() + 1, -1),
+			_width(g.size() + 1, 0),
+			_forward(g.size() + 1, 0),
+			_backward(g.size() + 1, 0),
+			_visited(g.size(), 0),
+			_search(0),
+			_span((1LL << 62) / (g.size() + 1)) {
+
+			int connections = 0;
+			std::vector<int> degree(g.size() + 1, 0);
+			std::vector<int> ready;
+			long long position = 0;
+
+			for (int i = 0; i < g.size(); i++) {
+				_members[component(i)].push_back(i);
+				for (int e = g.adjStart(i); e < g.adjEnd(i); e++) {
+					int j = g.target(e);
+					_successors[i].push_back(j);
+					_predecessors[j].push_back(i);
+					if (component(i) != component(j) && link(component(i), component(j), 1))
+						connections++;
+				}
+			}
+			g.changeConnect(connections - g.connectNo());
+
+			// Kahn's algorithm over the condensation
+			for (int k = 1; k <= g.size(); k++) {
+				degree[k] = _in[k].size();
+				if (!_members[k].empty() && degree[k] == 0)
+					ready.push_back(k);
+			}
+			while (!ready.empty()) {
+				int k = ready.back();
+				ready.pop_back();
+				_order[k] = position;
+				_width[k] = _span;
+				position += _span;
+				for (const std::pair<const int, int> &e : _out[k])
+					if (--degree[e.first] == 0)
+						ready.push_back(e.first);
+			}
+		}
+
+		// Edge between the vertices created with keys start and end
+		void insert(int start, int end) {
+			int a = _graph.vertex(start)->key();
+			int b = _graph.vertex(end)->key();
+
+			_successors[start - 1].push_back(end - 1);
+			_predecessors[end - 1].push_back(start - 1);
+
+			if (a == b)
+				return;
+			if (link(a, b, 1))
+				_graph.changeConnect(1);
+			if (_order[a] < _order[b])
+				return;
+
+			std::vector<int> forward;
+			std::vector<int> backward;
+			std::vector< std::pair<long long, long long> > positions;
+			std::vector<int> cycle;
+			int key = -1;
+
+			_search++;
+			reach(b, _order[a], forward);
+			reachBack(a, _order[b], backward);
+
+			for (int k : forward)
+				positions.push_back(std::make_pair(_order[k], _width[k]));
+			for (int k : backward)
+				if (_forward[k] != _search)
+					positions.push_back(std::make_pair(_order[k], _width[k]));
+			std::sort(positions.begin(), positions.end());
+
+			// A path from b back to a: the components on it, and only those, met both ways
+			if (_forward[a] == _search) {
+				for (int k : forward)
+					if (onCycle(k))
+						cycle.push_back(k);
+				key = merge(cycle);
+				forward.erase(std::remove_if(forward.begin(), forward.end(),
+					[&](int k) { return onCycle(k); }), forward.end());
+				backward.erase(std::remove_if(backward.begin(), backward.end(),
+					[&](int k) { return onCycle(k); }), backward.end());
+			}
+
+			auto before = [&](int x, int y) { return _order[x] < _order[y]; };
+			std::sort(forward.begin(), forward.end(), before);
+			std::sort(backward.begin(), backward.end(), before);
+
+			// Backward ones lowest, forward ones highest, the merged component anywhere between
+			for (size_t i = 0; i < backward.size(); i++) {
+				_order[backward[i]] = positions[i].first;
+				_width[backward[i]] = positions[i].second;
+			}
+			if (key != -1) {
+				_order[key] = positions[backward.size()].first;
+				_width[key] = positions[backward.size()].second;
+			}
+			for (size_t i = 0; i < forward.size(); i++) {
+				_order[forward[i]] = positions[positions.size() - forward.size() + i].first;
+				_width[forward[i]] = positions[positions.size() - forward.size() + i].second;
+			}
+		}
+
+		// Edge between the vertices created with keys start and end, one of them if repeated
+		void remove(int start, int end) {
+			int a = _graph.vertex(start)->key();
+			int b = _graph.vertex(end)->key();
+
+			if (!drop(_successors[start - 1], end - 1))
+				throw BadInput("no edge " + std::to_string(start) + " " + std::to_string(end) + " to delete");
+			drop(_predecessors[end - 1], start - 1);
+
+			if (a != b) {
+				if (unlink(a, b))
+					_graph.changeConnect(-1);
+				return;
+			}
+
+			if (reaches(a, start - 1, end - 1))
+				return;
+
+			std::vector< std::vector<int> > parts;
+			split(a, parts);
+			if (parts.size() == 1)
+				return;
+
+			// The connections of the component go, to be taken again from its members
+			for (const std::pair<const int, int> &e : _out[a])
+				_in[e.first].erase(a);
+			for (const std::pair<const int, int> &e : _in[a])
+				_out[e.first].erase(a);
+			_graph.changeConnect(-(int) (_out[a].size() + _in[a].size()));
+			_out[a].clear();
+			_in[a].clear();
+
+			if (_width[a] < (long long) parts.size())
+				spread();
+			long long order = _order[a];
+			long long width = _width[a] / parts.size();
+			std::vector<int> members;
+			members.swap(_members[a]);
+
+			_search++;
+			for (size_t p = 0; p < parts.size(); p++) {
+				int key = *std::min_element(parts[p].begin(), parts[p].end()) + 1;
+				for (int i : parts[p])
+					_graph.label(i, key);
+				_members[key].swap(parts[p]);
+				_order[key] = order + (parts.size() - 1 - p) * width;
+				_width[key] = width;
+				_forward[key] = _search;
+			}
+
+			for (int i : members) {
+				for (int j : _successors[i])
+					if (component(i) != component(j) && link(component(i), component(j), 1))
+						_graph.changeConnect(1);
+				for (int j : _predecessors[i])
+					if (_forward[component(j)] != _search && link(component(j), component(i), 1))
+						_graph.changeConnect(1);
+			}
+
+			_graph.changeSCC(parts.size() - 1);
+		}
+
+		void insert(const std::vector< std::pair<int, int> > &edges) {
+			for (const std::pair<int, int> &e : edges)
+				insert(e.first, e.second);
+		}
+
+		void remove(const std::vector< std::pair<int, int> > &edges) {
+			for (const std::pair<int, int> &e : edges)
+				remove(e.first, e.second);
+		}
+
+		// Same output as Graph::print, from the maps
+		void print(FILE *out = stdout) {
+			fprintf(out, "%d\n", _graph.sccNo());
+			fprintf(out, "%d\n", _graph.connectNo());
+
+			for (int k = 1; k <= _graph.size(); k++)
+				for (const std::pair<const int, int> &e : _out[k])
+					fprintf(out, "%d %d\n", k, e.first);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    SemiExternal
+|
+\----------------------------------------*/
+/* SCCs of a binary input whose edges need not fit in memory: the offsets and a few words per
+ * vertex are kept, and the edges are read from the file in blocks, in sequential passes. Inputs
+ * whose edges fit the budget are simply loaded and searched by Pearce.
+ *
+ * Otherwise the SCC of a pivot, the vertex of largest in-degree times out-degree, is peeled first:
+ * the vertices reached from it and those reaching it are marked along the edges in the same passes,
+ * in file order and in reverse by turns, and the SCC is where both marks meet. Graphs with a giant
+ * SCC, as crawls and random graphs, lose most of their edges to it, and when the rest fits the
+ * budget it is loaded and searched by Pearce. Passes that keep marking past PIVOT_PASSES give the
+ * pivot up, and nothing is peeled.
+ *
+ * The edges left are searched by DFS tree (semi-external DFS, after Sibeyn, Abello and Meyer): a root
+ * above all vertices starts as the tree, and every block of edges holding an edge to a later
+ * vertex outside the subtree of its start (a forward cross edge) has the DFS of the tree and the
+ * block replace the tree, tree children first. Such a DFS deepens the first vertex where it
+ * departs from the old preorder, so the depths in preorder grow at every change and the passes
+ * end; the first pass without a change leaves a DFS tree of the whole graph. Each block with such an
+ * edge costs an in-memory DFS of O(V + block), and nothing bounds the passes but the depths: on
+ * sparse random graphs they grow faster than V, about 2000 passes (150k vertices, 700k edges) for
+ * a budget of 2 edges a vertex, and 430 for 5, so this is the slow path of the mode.
+ *
+ * By finish time in that tree, the last vertex of an SCC to finish finishes after everything its
+ * SCC reaches, so the largest finish time a vertex reaches names its SCC. It is carried back
+ * along the edges, a pass at a time, and up the tree in memory between passes, until no pass
+ * changes it; every SCC has its own value after a few passes, as nothing outside it can raise it.
+ *
+ * The condensation is built the same way: key pairs of the edges between SCCs, gathered over
+ * ranges of start keys that fit the budget, sorted and written to a temporary file so that their
+ * count can be printed before them. Labels, counts and output are those of Graph */
+template <class O>
+class SemiExternal {
+
+	public:
+
+		typedef O Offset;   // type of the edge offsets
+
+	private:
+
+		struct Frame {
+			int    vertex;
+			int    child;   // next tree child
+			Offset edge;    // next edge of the block
+		};
+
+		static const int PIVOT_PASSES = 32;   // passes the reach of the pivot may take
+
+		int                  _fd;
+		off_t                _edges;      // file position of the first edge end
+		const int            _vertexNo;
+		const Offset         _edgeNo;
+		size_t               _budget;     // bytes for the edges held in memory
+		std::vector<Offset>  _start;
+		std::vector<int>     _keys;       // 0 while the SCC is not known
+		std::vector<int>     _block;
+
+		// DFS tree; vertex V is the root
+		std::vector<int>     _parent;
+		std::vector<int>     _childStart;
+		std::vector<int>     _children;
+		std::vector<int>     _order;      // preorder
+		std::vector<int>     _pre;
+		std::vector<int>     _last;       // largest preorder number in the subtree
+		std::vector<int>     _post;
+		std::vector<char>    _seen;
+		std::vector<Frame>   _frames;
+
+		int                  _sccNo;
+		Offset               _connectNo;
+		FILE                *_condensed;
+		int                  _passes;
+
+		void read(void *data, size_t bytes, off_t at) const {
+			while (bytes > 0) {
+				ssize_t done = pread(_fd, data, bytes, at);
+				if (done <= 0)
+					throw BadInput("binary input shorter than its header says");
+				data = (char *) data + done;
+				bytes -= done;
+				at += done;
+			}
+		}
+
+		// Edges first .. first + n - 1 into the block; ends out of range stop the run
+		void load(Offset first, Offset n) {
+			read(_block.data(), n * sizeof(int), _edges + (off_t) first * sizeof(int));
+			for (Offset i = 0; i < n; i++)
+				if (_block[i] < 0 || _block[i] >= _vertexNo)
+					throw BadInput("edge end " + std::to_string(_block[i]) + " out of range");
+		}
+
+		// Vertex of edge e
+		int source(Offset e) const {
+			return std::upper_bound(_start.begin(), _start.end(), e) - _start.begin() - 1;
+		}
+
+		// f(v, w) for every edge v -> w, in file order or in reverse, one block at a time
+		template <class F>
+		void scan(bool reverse, F f) {
+			Offset block = _block.size();
+
+			_passes++;
+			for (Offset done = 0; done < _edgeNo; done += block) {
+				Offset n = std::min(block, _edgeNo - done);
+				Offset first = reverse ? _edgeNo - done - n : done;
+				load(first, n);
+
+				if (!reverse) {
+					int v = source(first);
+					for (Offset i = 0; i < n; i++) {
+						while (first + i >= _start[v + 1])
+							v++;
+						f(v, _block[i]);
+					}
+				}
+				else {
+					int v = source(first + n - 1);
+					for (Offset i = n; i-- > 0;) {
+						while (first + i < _start[v])
+							v--;
+						f(v, _block[i]);
+					}
+				}
+			}
+		}
+
+		// The root with every vertex as its child, in order
+		void plant() {
+			int root = _vertexNo;
+
+			_parent.assign(_vertexNo + 1, root);
+			_childStart.assign(_vertexNo + 2, 0);
+			_childStart[root + 1] = _vertexNo;
+			_children.resize(_vertexNo);
+			_order.resize(_vertexNo + 1);
+			_pre.resize(_vertexNo + 1);
+			_last.resize(_vertexNo + 1);
+			_post.resize(_vertexNo + 1);
+			_seen.resize(_vertexNo + 1);
+
+			_order[0] = root;
+			_pre[root] = 0;
+			_last[root] = _vertexNo;
+			_post[root] = _vertexNo;
+			for (int v = 0; v < _vertexNo; v++) {
+				_children[v] = v;
+				_order[v + 1] = v;
+				_pre[v] = _last[v] = v + 1;
+				_post[v] = v;
+			}
+		}
+
+		// DFS of the tree and the edges of the block, which becomes the tree
+		void search(Offset first, Offset n) {
+			int root = _vertexNo;
+			int index = 0;
+			int finished = 0;
+
+			auto discover = [&](int w, int parent) {
+				_seen[w] = 1;
+				_parent[w] = parent;
+				_pre[w] = index;
+				_order[index++] = w;
+				Frame f = { w, _childStart[w], w < root ? std::max(_start[w], first) : first };
+				_frames.push_back(f);
+			};
+
+			std::fill(_seen.begin(), _seen.end(), 0);
+			discover(root, root);
+
+			while (!_frames.empty()) {
+				Frame &f = _frames.back();
+				int v = f.vertex;
+
+				if (f.child < _childStart[v + 1]) {
+					int w = _children[f.child++];
+					if (!_seen[w])
+						discover(w, v);
+				}
+				else if (v < root && _keys[v] == 0 && f.edge < std::min(_start[v + 1], first + n)) {
+					int w = _block[f.edge++ - first];
+					if (!_seen[w] && _keys[w] == 0)
+						discover(w, v);
+				}
+				else {
+					_last[v] = index - 1;
+					_post[v] = finished++;
+					_frames.pop_back();
+				}
+			}
+
+			/* Children in the order they were found; every list is filled from its start,
+			 * which moves to the next one, then the starts are shifted back */
+			std::fill(_childStart.begin(), _childStart.end(), 0);
+			for (int v = 0; v < root; v++)
+				_childStart[_parent[v] + 1]++;
+			for (int v = 1; v <= root + 1; v++)
+				_childStart[v] += _childStart[v - 1];
+			for (int i = 1; i <= root; i++) {
+				int v = _order[i];
+				_children[_childStart[_parent[v]]++] = v;
+			}
+			for (int v = root + 1; v > 0; v--)
+				_childStart[v] = _childStart[v - 1];
+			_childStart[0] = 0;
+		}
+
+		// Passes until no block holds a forward cross edge; labelled vertices are left out of the tree
+		void forest() {
+			Offset block = _block.size();
+			bool changed = true;
+
+			plant();
+			while (changed) {
+				changed = false;
+				_passes++;
+				for (Offset first = 0; first < _edgeNo; first += block) {
+					Offset n = std::min(block, _edgeNo - first);
+					int v = source(first);
+
+					load(first, n);
+					for (Offset i = 0; i < n; i++) {
+						while (first + i >= _start[v + 1])
+							v++;
+						if (_pre[_block[i]] > _last[v] && _keys[v] == 0 && _keys[_block[i]] == 0) {
+							search(first, n);
+							changed = true;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		// Largest finish time reached, carried back along the edges and up the tree
+		void components() {
+			std::vector<int> &reach = _last;
+			std::vector<int> &key = _pre;
+			int root = _vertexNo;
+			bool changed;
+
+			for (int v = 0; v < root; v++)
+				reach[v] = _post[v];
+
+			do {
+				for (int i = root; i > 0; i--) {
+					int v = _order[i];
+					if (_parent[v] != root && reach[v] > reach[_parent[v]])
+						reach[_parent[v]] = reach[v];
+				}
+				changed = false;
+				scan(_passes % 2 != 0, [&](int v, int w) {
+					if (reach[w] > reach[v] && _keys[v] == 0 && _keys[w] == 0) {
+						reach[v] = reach[w];
+						changed = true;
+					}
+				});
+			} while (changed);
+
+			// The first member met going up is the smallest and gives the key
+			std::fill(key.begin(), key.end(), 0);
+			for (int v = 0; v < root; v++) {
+				if (_keys[v] != 0)
+					continue;
+				if (key[reach[v]] == 0) {
+					key[reach[v]] = v + 1;
+					_sccNo++;
+				}
+				_keys[v] = key[reach[v]];
+			}
+		}
+
+		/* Edges between vertices not labelled yet, every one of them at once, searched in memory;
+		 * the blocks come in file order, so the ends are appended by start */
+		void finish(int distance) {
+			std::vector<int>    original(_vertexNo);
+			std::vector<Offset> start(_start);
+			std::vector<int>    targets;
+
+			for (int v = 0; v < _vertexNo; v++)
+				original[v] = v;
+
+			if (_sccNo > 0) {
+				std::fill(start.begin(), start.end(), 0);
+				scan(false, [&](int v, int w) {
+					if (_keys[v] == 0 && _keys[w] == 0)
+						start[v + 1]++;
+				});
+				for (int v = 0; v < _vertexNo; v++)
+					start[v + 1] += start[v];
+			}
+
+			targets.reserve(start[_vertexNo]);
+			scan(false, [&](int v, int w) {
+				if (_sccNo == 0 || (_keys[v] == 0 && _keys[w] == 0))
+					targets.push_back(w);
+			});
+
+			Reordering<Offset> all(original, start, targets);
+			Pearce<SemiExternal, Reordering<Offset> > p(*this, all, distance);
+			p.run();
+		}
+
+		/* Labels the SCC of the pivot and returns the edges left between unlabelled vertices, or
+		 * all of them when the pivot is given up. Bit 1 of a mark is reached from the pivot,
+		 * bit 2 reaching it */
+		Offset pivot() {
+			std::vector<char> mark(_vertexNo, 0);
+			Offset left = _edgeNo;
+			int pivot = 0;
+
+			{
+				std::vector<Offset> in(_vertexNo, 0);
+				double best = -1;
+
+				scan(false, [&](int, int w) { in[w]++; });
+				for (int v = 0; v < _vertexNo; v++)
+					if ((double) in[v] * (_start[v + 1] - _start[v]) > best) {
+						best = (double) in[v] * (_start[v + 1] - _start[v]);
+						pivot = v;
+					}
+			}
+
+			mark[pivot] = 3;
+			for (int pass = 0, changed = 1; changed; pass++) {
+				if (pass == PIVOT_PASSES)
+					return _edgeNo;
+				changed = 0;
+				left = 0;
+				scan(pass % 2 != 0, [&](int v, int w) {
+					if ((mark[v] & 1) && !(mark[w] & 1)) {
+						mark[w] |= 1;
+						changed = 1;
+					}
+					if ((mark[w] & 2) && !(mark[v] & 2)) {
+						mark[v] |= 2;
+						changed = 1;
+					}
+					if (mark[v] != 3 && mark[w] != 3)
+						left++;
+				});
+			}
+
+			for (int v = 0, key = 0; v < _vertexNo; v++)
+				if (mark[v] == 3) {
+					if (key == 0)
+						key = v + 1;
+					_keys[v] = key;
+				}
+			_sccNo++;
+			return left;
+		}
+
+		// Sorted, without repeats, the pairs of keys in the range are appended to _condensed
+		void condense(int first, int last, size_t capacity) {
+			std::vector<unsigned long long> pairs;
+
+			auto compact = [&]() {
+				std::sort(pairs.begin(), pairs.end());
+				pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+			};
+
+			scan(false, [&](int v, int w) {
+				if (_keys[v] < first || _keys[v] > last || _keys[v] == _keys[w])
+					return;
+				pairs.push_back((unsigned long long) _keys[v] << 32 | (unsigned) _keys[w]);
+				if (pairs.size() >= capacity)
+					compact();
+			});
+			compact();
+
+			for (unsigned long long p : pairs)
+				fprintf(_condensed, "%d %d\n", (int) (p >> 32), (int) (p & 0xFFFFFFFF));
+			_connectNo += pairs.size();
+		}
+
+	public:
+
+		// The header, at the current position of in, was already read into header
+		SemiExternal(FILE *in, const GraphHeader<Offset> &header, size_t budget) :
+			_fd(fileno(in)),
+			_vertexNo(header.vertexNo),
+			_edgeNo(header.edgeNo),
+			_budget(budget),
+			_start(header.vertexNo + 1),
+			_keys(header.vertexNo, 0),
+			_block(std::max((size_t) 4096, budget / sizeof(int))),
+			_sccNo(0),
+			_connectNo(0),
+			_condensed(NULL),
+			_passes(0) {
+			struct stat info;
+			off_t base = ftell(in) - sizeof(header);
+
+			if (fstat(_fd, &info) != 0 || !S_ISREG(info.st_mode) || base < 0 || (size_t) info.st_size < base + header.bytes())
+				throw BadInput("the semi-external mode needs a binary input file");
+			if (fread(_start.data(), sizeof(Offset), _start.size(), in) != _start.size())
+				throw BadInput("binary input shorter than its header says");
+			_edges = base + sizeof(header) + _start.size() * sizeof(Offset);
+			posix_fadvise(_fd, _edges, 0, POSIX_FADV_SEQUENTIAL);
+		}
+
+		~SemiExternal() {
+			if (_condensed != NULL)
+				fclose(_condensed);
+		}
+
+		// Offsets increasing from 0 to E; ends are checked as the passes read them
+		bool check() const {
+			if (_start[0] != 0 || _start[_vertexNo] != _edgeNo)
+				return false;
+			for (int i = 0; i < _vertexNo; i++)
+				if (_start[i] > _start[i + 1])
+					return false;
+			return true;
+		}
+
+		// Labels, as Pearce writes them on the graph
+		bool peeled(int i) const   { return _keys[i] != 0; }
+		void label(int i, int key) { _keys[i] = key; }
+		void incrementSCC()        { _sccNo++; }
+
+		void run(int distance) {
+			if ((size_t) _edgeNo <= _block.size() || (size_t) pivot() <= _block.size()) {
+				finish(distance);
+				return;
+			}
+			forest();
+			components();
+		}
+
+		// Once run is done; the tree gives its memory back
+		void clear() {
+			std::vector<int>().swap(_parent);
+			std::vector<int>().swap(_childStart);
+			std::vector<int>().swap(_children);
+			std::vector<int>().swap(_order);
+			std::vector<int>().swap(_pre);
+			std::vector<int>().swap(_last);
+			std::vector<int>().swap(_post);
+			std::vector<char>().swap(_seen);
+			std::vector<Frame>().swap(_frames);
+		}
+
+		/* Start keys in ranges whose pairs, before removing repeats, fit the budget; a key
+		 * with more pairs than that has a range of its own, compacted as it fills */
+		void condense() {
+			size_t capacity = std::max((size_t) 1, _budget / sizeof(unsigned long long));
+			std::vector<Offset> count(_vertexNo + 1, 0);
+
+			_condensed = tmpfile();
+			if (_condensed == NULL)
+				throw std::runtime_error("cannot create a temporary file");
+
+			scan(false, [&](int v, int w) {
+				if (_keys[v] != _keys[w])
+					count[_keys[v]]++;
+			});
+
+			int first = 1;
+			size_t size = 0;
+			for (int k = 1; k <= _vertexNo; k++) {
+				if (size > 0 && size + count[k] > capacity) {
+					condense(first, k - 1, capacity);
+					first = k;
+					size = 0;
+				}
+				size += count[k];
+			}
+			if (size > 0)
+				condense(first, _vertexNo, capacity);
+		}
+
+		std::vector< std::pair<std::string, size_t> > memory() const {
+			std::vector< std::pair<std::string, size_t> > usage;
+			size_t tree = (_parent.capacity() + _childStart.capacity() + _children.capacity() + _order.capacity() +
+				_pre.capacity() + _last.capacity() + _post.capacity()) * sizeof(int) + _seen.capacity() + _frames.capacity() * sizeof(Frame);
+
+			usage.push_back(std::make_pair("offsets", _start.capacity() * sizeof(Offset)));
+			usage.push_back(std::make_pair("keys", _keys.capacity() * sizeof(int)));
+			usage.push_back(std::make_pair("block", _block.capacity() * sizeof(int)));
+			usage.push_back(std::make_pair("tree", tree));
+			return usage;
+		}
+
+		void print(FILE *out = stdout) const {
+			char buffer[1 << 16];
+			size_t read;
+
+			fprintf(out, "%d\n", _sccNo);
+			fprintf(out, "%lld\n", (long long) _connectNo);
+
+			rewind(_condensed);
+			while ((read = fread(buffer, 1, sizeof(buffer), _condensed)) > 0)
+				fwrite(buffer, 1, read, out);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    main
+|
+|----------------------------------------*/
+bool parseEngine(const char *name, Engine &engine) {
+	if (!strcmp(name, "tarjan"))
+		engine = TARJAN;
+	else if (!strcmp(name, "pearce"))
+		engine = PEARCE;
+	else if (!strcmp(name, "states"))
+		engine = STATES;
+	else if (!strcmp(name, "ufscc"))
+		engine = UFSCC;
+	else
+		return false;
+	return true;
+}
+
+bool parseOrder(const char *name, Order &order) {
+	if (!strcmp(name, "bfs"))
+		order = BFS_ORDER;
+	else if (!strcmp(name, "degree"))
+		order = DEGREE_ORDER;
+	else if (!strcmp(name, "rcm"))
+		order = RCM_ORDER;
+	else
+		return false;
+	return true;
+}
+
+#ifndef PROJECT_NO_MAIN
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-e engine] [-j threads] [-t] [-o order] [-c] [-d dist] [-x mb] [-u file] [-p] [-P file] [-s socket] < input\n", name);
+	fprintf(stderr, "       %s [options] -b outdir [-w workers] input|dir...\n", name);
+	fprintf(stderr, " -e engine : tarjan (default), pearce (one word and one bit per vertex) or states (tarjan\n");
+	fprintf(stderr, "             through successors and a hash table, as for state spaces) or ufscc (the\n");
+	fprintf(stderr, "             same on several threads, sharing a union-find)\n");
+	fprintf(stderr, " -j threads: workers of ufscc; 0 uses every core (default)\n");
+	fprintf(stderr, " -t        : peel trivial SCCs (trim-1, trim-2) before the engine runs\n");
+	fprintf(stderr, " -o order  : renumber the vertices by bfs, degree or rcm before searching; not tarjan\n");
+	fprintf(stderr, " -c        : search a delta and varint compressed copy of the adjacency; not tarjan\n");
+	fprintf(stderr, " -d dist   : prefetch distance in edges for the engines; 0 turns it off (default %d)\n", PREFETCH_DISTANCE);
+	fprintf(stderr, " -x mb     : semi-external; the edges of a binary input file stay on disk and are read in\n");
+	fprintf(stderr, "             passes, with mb megabytes for the edges held in memory; slow (passes growing\n");
+	fprintf(stderr, "             faster than V) on inputs that still do not fit once the SCC of the busiest\n");
+	fprintf(stderr, "             vertex is out\n");
+	fprintf(stderr, " -u file   : batches of edges to insert or delete after the first output, each \"+ n\" or\n");
+	fprintf(stderr, "             \"- n\" and then n edges; the SCCs are updated and printed again after every\n");
+	fprintf(stderr, "             batch; text input only\n");
+	fprintf(stderr, " -p        : wall time and hardware counters of every phase, as a table on stderr\n");
+	fprintf(stderr, " -P file   : the same, as JSON in file\n");
+	fprintf(stderr, " input     : text, or binary from convert (searched by pearce, or by states or ufscc)\n");
+	fprintf(stderr, " -s socket : stay up and serve inputs sent to a Unix socket, each answered on its connection;\n");
+	fprintf(stderr, "             every graph is built afresh, only the memory a job frees stays mapped for the\n");
+	fprintf(stderr, "             next one; SIGINT or SIGTERM stops the server\n");
+	fprintf(stderr, " -b outdir : batch; every input file, and every .in file of every dir, is solved into\n");
+	fprintf(stderr, "             outdir/name.out, several at once\n");
+	fprintf(stderr, " -w workers: files solved at once in batch mode; 0 uses every core (default)\n");
+	exit(1);
+}
+#endif
+
+struct Settings {
+	Engine engine;
+	bool   trim;
+	Order  order;
+	bool   compress;
+	int    distance;
+	int    threads;    // workers of ufscc
+	size_t external;   // bytes for edges in the semi-external mode; 0 loads the whole input
+	const char *updates;    // batches of edges inserted or deleted after the first output, or NULL
+};
+
+// Binary input file searched with its edges on disk
+template <class Offset>
+void processExternal(FILE *in, FILE *out, const GraphHeader<Offset> &header, const Settings &settings, Profiler &profiler) {
+
+	SemiExternal<Offset> g(in, header, settings.external);
+	if (!g.check())
+		throw BadInput("bad offsets in the binary input");
+	profiler.lap("load");
+
+	g.run(settings.distance);
+	profiler.lap("scc");
+
+	if (profiler.enabled())
+		profiler.structures(g.memory());
+	g.clear();
+
+	g.condense();
+	profiler.lap("condense");
+
+	g.print(out);
+	fflush(out);
+	profiler.lap("print");
+
+}
+
+/* A CSR without vertex objects, from binary input or read from text: searched in place by Pearce,
+ * or by the state space search with -e states or ufscc; trim, reordering and compression still
+ * apply. Offset follows the offsets of the CSR, so small graphs keep 32-bit arrays all the way */
+template <class Offset>
+void processCSR(MappedGraph<Offset> &g, FILE *out, const Settings &settings, Profiler &profiler) {
+
+	if (settings.trim) {
+		Trim< MappedGraph<Offset> > t(g);
+		t.run();
+		profiler.lap("trim");
+	}
+
+	Reordering<Offset> *r = NULL;
+	Compressed<Offset> *c = NULL;
+
+	if (settings.order != ORIGINAL) {
+		r = new Reordering<Offset>(g, settings.order);
+		profiler.lap("reorder");
+	}
+
+	if (settings.compress) {
+		c = r != NULL ? new Compressed<Offset>(*r) : new Compressed<Offset>(g);
+		delete r;
+		r = NULL;
+		profiler.lap("compress");
+	}
+
+	if (settings.engine == STATES || settings.engine == UFSCC) {
+		int threads = settings.engine == UFSCC ? settings.threads : -1;
+		if (c != NULL)
+			CSRSpace<MappedGraph<Offset>, Compressed<Offset> >::label(g, *c, threads);
+		else if (r != NULL)
+			CSRSpace<MappedGraph<Offset>, Reordering<Offset> >::label(g, *r, threads);
+		else
+			CSRSpace<MappedGraph<Offset>, MappedGraph<Offset> >::label(g, g, threads);
+	}
+	else if (c != NULL) {
+		Pearce<MappedGraph<Offset>, Compressed<Offset> > p(g, *c, settings.distance);
+		p.run();
+	}
+	else if (r != NULL) {
+		Pearce<MappedGraph<Offset>, Reordering<Offset> > p(g, *r, settings.distance);
+		p.run();
+	}
+	else {
+		Pearce<MappedGraph<Offset>, MappedGraph<Offset> > p(g, g, settings.distance);
+		p.run();
+	}
+	profiler.lap("scc");
+
+	if (profiler.enabled()) {
+		profiler.structures(g.memory());
+		if (r != NULL)
+			profiler.structures({ std::make_pair(std::string("reordering"), r->bytes()) });
+		if (c != NULL)
+			profiler.structures({ std::make_pair(std::string("compressed"), c->bytes()) });
+	}
+	delete r;
+	delete c;
+
+	g.condense();
+	profiler.lap("condense");
+
+	g.print(out);
+	fflush(out);
+	profiler.lap("print");
+
+}
+
+// Binary input, with the header already read; tarjan has no vertex objects to run on
+template <class Offset>
+void processBinary(FILE *in, FILE *out, const GraphHeader<Offset> &header, const Settings &settings, Profiler &profiler) {
+
+	if (!header.valid())
+		throw BadInput("bad binary header");
+
+	if (settings.external > 0) {
+		processExternal(in, out, header, settings, profiler);
+		return;
+	}
+
+	Mapping mapping(in, &header, sizeof(header), header.bytes());
+	MappedGraph<Offset> g(mapping.data());
+	if (!g.check())
+		throw BadInput("bad offsets or edge ends in the binary input");
+	profiler.lap("load");
+
+	processCSR(g, out, settings, profiler);
+
+}
+
+/* Text input for the CSR engines, read into the binary form of convert instead of Vertex and Edge
+ * objects: two ints per edge while reading, one once the ends are sorted by start (stable, as
+ * Graph::sortByStart), and the edge list of Graph is never built */
+void processText(FILE *in, FILE *out, int vertexNo, int edgeNo, const Settings &settings, Profiler &profiler) {
+
+	GraphHeader<int> header;
+	std::vector<char> image;
+
+	memcpy(header.magic, GraphHeader<int>::tag(), 4);
+	header.vertexNo = vertexNo;
+	header.edgeNo = edgeNo;
+
+	{
+		std::vector<int> starts(edgeNo);
+		std::vector<int> ends(edgeNo);
+
+		for (int i = 0; i < edgeNo; i++) {
+			if (fscanf(in, "%d %d", &starts[i], &ends[i]) != 2)
+				throw BadInput("edge " + std::to_string(i + 1) + " missing");
+			for (int key : { starts[i], ends[i] })
+				if (key < 1 || key > vertexNo)
+					throw BadInput("vertex " + std::to_string(key) + " out of range");
+		}
+		profiler.lap("load");
+
+		image.resize(header.bytes());
+		memcpy(image.data(), &header, sizeof(header));
+		int *start = (int *) (image.data() + sizeof(header));
+		int *targets = start + vertexNo + 1;
+
+		// Counting sort by start, as in generateAdjacency; start[i] is used up as the next slot of i
+		for (int i = 0; i < edgeNo; i++)
+			start[starts[i]]++;
+		for (int v = 1; v <= vertexNo; v++)
+			start[v] += start[v - 1];
+		for (int i = 0; i < edgeNo; i++)
+			targets[start[starts[i] - 1]++] = ends[i] - 1;
+		for (int v = vertexNo; v > 0; v--)
+			start[v] = start[v - 1];
+		start[0] = 0;
+	}
+
+	MappedGraph<int> g(image.data());
+	profiler.lap("adjacency");
+
+	processCSR(g, out, settings, profiler);
+
+}
+
+// Reads the header of a binary input, as wide as its magic says
+void processBinary(FILE *in, FILE *out, const Settings &settings, Profiler &profiler) {
+
+	GraphHeader<int> narrow;
+	GraphHeader<long long> wide;
+
+	if (fread(&narrow, sizeof(narrow), 1, in) != 1)
+		throw BadInput("binary header missing");
+
+	if (memcmp(narrow.magic, GraphHeader<long long>::tag(), 4) != 0) {
+		processBinary(in, out, narrow, settings, profiler);
+		return;
+	}
+
+	// The wide header starts as the narrow one, then has 4 more bytes
+	memcpy(&wide, &narrow, sizeof(narrow));
+	if (fread((char *) &wide + sizeof(narrow), sizeof(wide) - sizeof(narrow), 1, in) != 1)
+		throw BadInput("binary header missing");
+	processBinary(in, out, wide, settings, profiler);
+}
+
+/* Batches of edges from path, each as "+ n" or "- n" and then n edges, inserted into or deleted
+ * from the labelled graph; the output is printed again after every batch */
+void update(Graph &g, const char *path, FILE *out) {
+	FILE *in = fopen(path, "r");
+	char sign;
+	int n;
+	int read;
+
+	if (in == NULL)
+		throw BadInput(std::string("cannot read ") + path);
+
+	try {
+		Dynamic d(g);
+		while ((read = fscanf(in, " %c %d", &sign, &n)) == 2) {
+			if ((sign != '+' && sign != '-') || n < 0)
+				throw BadInput("bad batch header in the updates");
+			std::vector< std::pair<int, int> > edges(n);
+			for (std::pair<int, int> &e : edges)
+				if (fscanf(in, "%d %d", &e.first, &e.second) != 2)
+					throw BadInput("edge missing in the updates");
+			if (sign == '+')
+				d.insert(edges);
+			else
+				d.remove(edges);
+			d.print(out);
+		}
+		if (read != EOF)
+			throw BadInput("bad batch header in the updates");
+	}
+	catch (...) {
+		fclose(in);
+		throw;
+	}
+
+	fclose(in);
+	fflush(out);
+}
+
+// One whole run, from the input in to the output out; binary inputs open with their magic
+void process(FILE *in, FILE *out, const Settings &settings, Profiler &profiler) {
+
+	int vertexNo;
+	int edgeNo;
+
+	int c = getc(in);
+	ungetc(c, in);
+	if (c == 'S') {
+		if (settings.updates != NULL)
+			throw BadInput("updates apply to text input, with vertex objects");
+		processBinary(in, out, settings, profiler);
+		return;
+	}
+
+	if (settings.external > 0)
+		throw BadInput("the semi-external mode reads binary input, from convert");
+
+	// Reading input; creation of objects
+	long long vertices;
+	long long edges;
+	if (fscanf(in, "%lld %lld", &vertices, &edges) != 2 || vertices < 1 || edges < 0)
+		throw BadInput("bad header");
+
+	// Graph keeps int offsets and one object per edge; larger inputs go through convert
+	if (vertices > INT_MAX || edges > INT_MAX)
+		throw BadInput(std::to_string(vertices) + " vertices and " + std::to_string(edges) +
+			" edges: too large for text input, use convert");
+	vertexNo = vertices;
+	edgeNo = edges;
+
+	// Objects only for tarjan, and for the updates of Dynamic
+	if (settings.engine != TARJAN && settings.updates == NULL) {
+		processText(in, out, vertexNo, edgeNo, settings, profiler);
+		return;
+	}
+
+	Graph g(vertexNo, edgeNo);
+	SCCFinder finder(g, settings.engine, settings.distance, settings.threads);
+
+	g.load(in);
+	profiler.lap("load");
+
+	// Main procedure
+	g.sortByStart();
+	g.generateAdjacency();
+	if (settings.updates != NULL)
+		g.generateTargets();
+	profiler.lap("adjacency");
+
+	if (settings.trim) {
+		finder.trim();
+		profiler.lap("trim");
+	}
+
+	if (settings.order != ORIGINAL) {
+		finder.reorder(settings.order);
+		profiler.lap("reorder");
+	}
+
+	if (settings.compress) {
+		finder.compress();
+		profiler.lap("compress");
+	}
+
+	finder.run();
+	profiler.lap("scc");
+
+	if (profiler.enabled()) {
+		profiler.structures(g.memory());
+		if (settings.order != ORIGINAL && !settings.compress)
+			profiler.structures({ std::make_pair(std::string("reordering"), finder.reorderingBytes()) });
+		if (settings.compress)
+			profiler.structures({ std::make_pair(std::string("compressed"), finder.compressedBytes()) });
+	}
+
+	g.sortByEnd();
+	g.sortByStart();
+	g.connectionsNumber();
+	profiler.lap("condense");
+
+	g.print(out);
+	fflush(out);
+	profiler.lap("print");
+
+	if (settings.updates != NULL) {
+		update(g, settings.updates, out);
+		profiler.lap("update");
+	}
+
+	// Deletion of objects
+	g.unload();
+	profiler.lap("unload");
+
+}
+
+#ifndef PROJECT_NO_MAIN
+int main(int argc, char *argv[]) {
+
+	Settings settings = { TARJAN, false, ORIGINAL, false, PREFETCH_DISTANCE, 0, 0, NULL };
+	Profiler profiler;
+	bool table = false;
+	const char *jsonFile = NULL;
+	const char *socketPath = NULL;
+	const char *outputDir = NULL;
+	int workers = 0;
+	std::vector<const char *> paths;
+
+	// Options
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+			if (!parseEngine(argv[++i], settings.engine))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			settings.threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t"))
+			settings.trim = true;
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc) {
+			if (!parseOrder(argv[++i], settings.order))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-c"))
+			settings.compress = true;
+		else if (!strcmp(argv[i], "-d") && i + 1 < argc)
+			settings.distance = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-x") && i + 1 < argc) {
+			int megabytes = atoi(argv[++i]);
+			if (megabytes < 1)
+				usage(argv[0]);
+			settings.external = (size_t) megabytes << 20;
+		}
+		else if (!strcmp(argv[i], "-u") && i + 1 < argc)
+			settings.updates = argv[++i];
+		else if (!strcmp(argv[i], "-p"))
+			table = true;
+		else if (!strcmp(argv[i], "-P") && i + 1 < argc)
+			jsonFile = argv[++i];
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			socketPath = argv[++i];
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+			outputDir = argv[++i];
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			workers = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			paths.push_back(argv[i]);
+		else
+			usage(argv[0]);
+	}
+
+	// Tarjan walks the vertex objects, not the CSR
+	if (((settings.order != ORIGINAL || settings.compress) && settings.engine == TARJAN) || settings.distance < 0 || settings.threads < 0)
+		usage(argv[0]);
+
+	// The semi-external mode has no CSR of its own to trim, renumber or compress
+	if (settings.external > 0 && (settings.trim || settings.order != ORIGINAL || settings.compress))
+		usage(argv[0]);
+
+	// Updates follow the single run on stdin, on its vertex objects
+	if (settings.updates != NULL && (settings.external > 0 || socketPath != NULL || outputDir != NULL))
+		usage(argv[0]);
+
+	// Input files only in batch mode, and at least one there
+	if (paths.empty() != (outputDir == NULL))
+		usage(argv[0]);
+
+	// The profiler measures a single run
+	if ((socketPath != NULL || outputDir != NULL) && (table || jsonFile != NULL))
+		usage(argv[0]);
+
+	if (outputDir != NULL) {
+		std::vector<std::string> inputs;
+		if (socketPath != NULL)
+			usage(argv[0]);
+		listInputs(paths, inputs);
+		return batch(inputs, outputDir, workers, [&](FILE *in, FILE *out) {
+			Profiler profiler;
+			process(in, out, settings, profiler);
+		}) ? 0 : 1;
+	}
+
+	if (socketPath != NULL) {
+		// Memory freed by a job stays with the process, already mapped, for the next one
+		mallopt(M_MMAP_THRESHOLD, 1 << 30);
+		mallopt(M_TRIM_THRESHOLD, -1);
+
+		Server server(socketPath);
+		return server.run([&](FILE *in, FILE *out) { process(in, out, settings, profiler); }) ? 0 : 1;
+	}
+
+	if (table || jsonFile != NULL)
+		profiler.start();
+
+	try {
+		process(stdin, stdout, settings, profiler);
+	}
+	catch (const std::exception &e) {
+		fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return 1;
+	}
+
+	if (table)
+		profiler.print(stderr);
+	if (jsonFile != NULL) {
+		FILE *out = fopen(jsonFile, "w");
+		if (out == NULL) {
+			fprintf(stderr, "%s: cannot write %s\n", argv[0], jsonFile);
+			return 1;
+		}
+		profiler.json(out);
+		fclose(out);
+	}
 
 	return 0;
 
 }
+#endif
@@ -16,7 +16,8 @@ fi
 
 # Repetitions for each size
 opsNo=2
-reps=1
+reps=5
+warmup=1
 
 # Bounds and increment for consecutive tests
 lower=50
@@ -31,18 +32,20 @@ currentDir=$(pwd);
 work="$2"
 
 # Generator variables
-gen="${currentDir}/gerador"
+gen="${currentDir}/generator"
 
 # Public tests variables
 testsZip="bigIO.zip"
 tests="bigio"
 
 bin="p2";
-time="/usr/bin/time"
-valgrind="valgrind --tool=massif"
+bench="p2-bench"
+telemetry="p2-telemetry"
 
-# Compile project
-(g++ -Wall -O3 -o $bin -lm $1)
+# Compile project, benchmark and graph generator
+(g++ -Wall -O3 -pthread -o $bin -lm $1)
+(g++ -Wall -O3 -pthread -o $bench -lm -DPROJECT_SOURCE="\"$1\"" benchmark.cpp)
+(g++ -Wall -O3 -pthread -o $gen generator.cpp)
 
 
 # Runs tests
@@ -62,7 +65,33 @@ if [ "$work" == "tests" ]; then
 
 	rm -rf $tests
 
-	rm -f $bin
+	# Islands: zero weights between columns 5 | 6 and 10 | 11 cut the image in three, each
+	# component is solved on its own with -j, and the flows of the components, as counted by the
+	# telemetry build, add up to the flow of plain ek
+	(g++ -Wall -O3 -pthread -DMAXFLOW_TELEMETRY -o $telemetry -lm $1)
+	awk -v m=8 -v n=15 'function rows(h, w, f,    i, j) {
+		for (i = 0; i < h; i++) {
+			for (j = 0; j < w; j++)
+				printf "%d ", f == 1 ? (3 * i + 7 * j) % 10 : f == 2 ? (5 * i + 3 * j) % 9 : f == 3 ? (j % 5 == 4 ? 0 : 1 + (i + j) % 4) : 1 + (i * j) % 5
+			printf "\n"
+		}
+		printf "\n"
+	}
+	BEGIN { printf "%d %d\n\n", m, n; rows(m, n, 1); rows(m, n, 2); rows(m, n - 1, 3); rows(m - 1, n, 4) }' > islands.in
+
+	ek=$(./$bin -e ek < islands.in | head -1)
+	split=$(./$telemetry -e ek -j 0 < islands.in 2> telemetry.json | head -1)
+	solves=$(grep -o '"solves": [0-9]*' telemetry.json | awk '{print $2}')
+	parts=$(grep -o '"\(startingFlow\|mainFlow\)": [0-9]*' telemetry.json | awk '{sum += $2} END {print sum}')
+	if [[ "$split" == "$ek" && "$parts" == "$ek" && "$solves" -gt 1 ]]; then
+		echo "islands successful; $solves components, flow $ek"
+	else
+		echo "islands FAILED; $solves components, flows $parts and $split, ek $ek"
+	fi
+
+	rm -f islands.in telemetry.json
+
+	rm -f $bin $bench $gen $telemetry
 
 	# If running tests only, script ends here
 	exit
@@ -75,21 +104,14 @@ if [ "$work" != "mem" ]; then
 
 	message="Running time tests; sparse graphs"
 
-	printf "[vertexNumber] [time]\n"
+	printf "[vertexNumber] [vertexNumber^3] [time]\n"
 
 	for ops in $(seq $opsNo); do
 		# Runs tests for plotting; sparse graphs, then dense graphs
 		echo $message;
 		for size in $(seq $lower $incr $upper); do
-			($gen $size $ops > graph-${size}-${ops}.in)
-			for i in $(seq $reps); do
-				res=$( $time -f "%e" ./$bin < graph-${size}-${ops}.in 2>&1 > /dev/null )
-				firstline=$(head graph-${size}-${ops}.in | awk '{print $1 " " $2; exit}')
-				vert=$(( ${firstline% *} * ${firstline#* } ))
-				( printf "%s %s %s\n" $vert $res )
-			done
+			./$bench -w $warmup -r $reps -f txt -g $size,$ops
 		done
-		rm -f graph-*.in
 		message="Running time tests; dense graphs"
 		sleep 1
 	done
@@ -103,30 +125,24 @@ if [ "$work" != "time" ]; then
 
 	echo "Running memory tests; dense graphs only"
 
-	printf "[vertexNumber] [totalMemory] [time]\n"
+	printf "[vertexNumber] [heapPeak] [time]\n"
 
 	# Runs tests for plotting; #edges = #vertices
 	for size in $(seq $lower $incr $upperVG); do
 
-		($gen $size 2 > graph-${size}-2.in)
-		($valgrind ./$bin   < graph-${size}-2.in > /dev/null)
+		# Generated straight into the project, so no graph file piles up on disk;
+		# the image is (2n + 1) x 2n pixels
+		($gen $size 2 | ./$bin -P mem.json > /dev/null)
 
-		firstline=$(head graph-${size}-${ops}.in | awk '{print $1 " " $2; exit}')
-		vert=$(( ${firstline% *} * ${firstline#* } ))
+		vert=$(( (2 * size + 1) * 2 * size ))
 
-		memTotal=0;
-		timeRes=$(cat massif.* | grep -B 4 "peak" | grep "time" | awk -F '=' '{print $2}')
-		for element in $(cat massif.* | grep -B 3 "peak" | grep -v "peak" | tr "\n" "\t"); do
-			memory=${element##*=}
-			memTotal=$(( memTotal + memory ))
-		done
-		rm -f massif.*
+		memTotal=$(grep -o '"heapPeak": [0-9]*' mem.json | head -1 | awk '{print $2}')
+		timeRes=$(grep -o '"wall": [0-9.]*' mem.json | head -1 | awk '{print $2}')
+		rm -f mem.json
 		( printf "%s %s %s\n" $vert $memTotal $timeRes )
 	done
 
-	rm -f graph-*.in
-
 fi
 
-# Remove compiled file
-rm -f $bin
\ No newline at end of file
+# Remove compiled files
+rm -f $bin $bench $gen
\ No newline at end of file
@@ -0,0 +1,165 @@
+// Benchmark
+
+/* Times every phase of process, the run of main, on inputs read into memory once: a few warm-up
+ * runs are discarded, then every repetition is timed phase by phase at the laps process makes.
+ * Parse and print are still phases of their own, but process start-up and disk reads are no
+ * longer in the numbers. Inputs are files, text or binary, or generator parameters; generated
+ * inputs never touch the disk */
+
+#define PROJECT_NO_MAIN
+#ifndef PROJECT_SOURCE
+#define PROJECT_SOURCE "project_final.cpp"
+#endif
+#include PROJECT_SOURCE
+
+#define GENERATOR_NO_MAIN
+#include "generator.cpp"
+
+#include "../common/benchmark.h"
+
+/*---------------------------------------
+|
+|    Pipeline
+|
+\----------------------------------------*/
+// m * n of a text or binary input, the size used by the plots
+long long size(const std::string &text) {
+	ImageHeader header;
+	int m = 0;
+	int n = 0;
+
+	if (text.compare(0, 4, "SEG1") == 0 && text.size() >= sizeof(header)) {
+		memcpy(&header, text.data(), sizeof(header));
+		return (long long) header.m * header.n;
+	}
+	sscanf(text.c_str(), "%d %d", &m, &n);
+	return (long long) m * n;
+}
+
+// The [vertexNumber^3] column of results1.txt, which the plots fit the time against
+double cube(long long size) {
+	return (double) size * size * size;
+}
+
+// One run of process, timed at its laps
+void run(const std::string &text, const Settings &settings, Timings &t, FILE *sink) {
+	Profiler profiler;
+	FILE *in = fmemopen((void *) text.data(), text.size(), "r");
+
+	if (in == NULL)
+		throw std::runtime_error("cannot open the input in memory");
+	profiler.hook([&t](const char *phase) { t.lap(phase); });
+
+	t.start();
+	try {
+		process(in, sink, settings, profiler);
+	}
+	catch (...) {
+		fclose(in);
+		throw;
+	}
+	t.stop();
+
+	fclose(in);
+}
+
+/*---------------------------------------
+|
+|    main
+|
+|----------------------------------------*/
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-e engine] [-j threads] [-l lambdas] [-w warmup] [-r reps] [-f txt|csv|json] [-g params]... [input]...\n", name);
+	fprintf(stderr, " -e engine  : ek (default), scaling, bidir or pseudo, as in project_final\n");
+	fprintf(stderr, " -j threads : solve independent components in parallel; 0 uses every core\n");
+	fprintf(stderr, " -l lambdas : parametric sweep over the listed lambdas, as in project_final\n");
+	fprintf(stderr, " -w warmup  : untimed runs before measuring (default 1)\n");
+	fprintf(stderr, " -r reps    : timed runs per input (default 5)\n");
+	fprintf(stderr, " -f format  : txt (\"size size^3 seconds\" as in results/results1.txt), csv (default) or json\n");
+	fprintf(stderr, " -g params  : generated input, parameters of generator as n,ops[,noise,seed]\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+	Settings settings = { EDMONDS_KARP, -1, std::vector<int>(), NULL };
+	int warmup = 1;
+	int reps = 5;
+	Format format = CSV;
+	std::vector<std::string> inputs;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+			if (!parseEngine(argv[++i], settings.engine))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			settings.threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+			if (!parseList(argv[++i], settings.lambdas))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			warmup = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+			reps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+			if (!parseFormat(argv[++i], format))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-g") && i + 1 < argc)
+			inputs.push_back(std::string("gen:") + argv[++i]);
+		else if (argv[i][0] == '-')
+			usage(argv[0]);
+		else
+			inputs.push_back(argv[i]);
+	}
+
+	if (inputs.empty() || reps < 1 || warmup < 0)
+		usage(argv[0]);
+
+	FILE *sink = fopen("/dev/null", "w");
+	Report report(format, stdout, cube);
+	Timings t;
+	std::string text;
+
+	report.begin();
+	for (const std::string &input : inputs) {
+		if (input.compare(0, 4, "gen:") == 0) {
+			std::vector<long long> params;
+			if (!parseParams(input.c_str() + 4, params) || params.size() < 2 || params.size() > 4)
+				usage(argv[0]);
+			Generator gen(params[0], params[1],
+				params.size() > 2 ? params[2] : 0,
+				params.size() > 3 ? params[3] : 0);
+			if (gen.check() != NULL) {
+				fprintf(stderr, "%s: %s\n", argv[0], gen.check());
+				return 1;
+			}
+			text = gen.text();
+		}
+		else if (!readFile(input.c_str(), text)) {
+			fprintf(stderr, "%s: cannot read %s\n", argv[0], input.c_str());
+			return 1;
+		}
+
+		try {
+			for (int i = 0; i < warmup; i++)
+				run(text, settings, t, sink);
+			t.clear();
+			for (int i = 0; i < reps; i++)
+				run(text, settings, t, sink);
+		}
+		catch (const std::exception &e) {
+			fprintf(stderr, "%s: %s: %s\n", argv[0], input.c_str(), e.what());
+			return 1;
+		}
+
+		report.add(input.c_str(), size(text), t);
+	}
+	report.end();
+
+	fclose(sink);
+	return 0;
+
+}
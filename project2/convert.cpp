@@ -0,0 +1,47 @@
+// Convert
+
+/* Text input to the binary format of project_final (ImageHeader, then every capacity in the order
+ * of the text), so that runs on it start without parsing */
+
+#define PROJECT_NO_MAIN
+#ifndef PROJECT_SOURCE
+#define PROJECT_SOURCE "project_final.cpp"
+#endif
+#include PROJECT_SOURCE
+
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s < input > input.bin\n", name);
+	fprintf(stderr, " input : an image in the text format of project_final, \"m n\" and then its capacities\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+	ImageHeader header;
+
+	if (argc != 1)
+		usage(argv[0]);
+
+	memcpy(header.magic, "SEG1", 4);
+	if (fscanf(stdin, "%d %d", &header.m, &header.n) != 2 || !header.valid()) {
+		fprintf(stderr, "%s: bad header\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<int> capacities(header.capacities());
+	for (size_t i = 0; i < capacities.size(); i++)
+		if (fscanf(stdin, "%d", &capacities[i]) != 1) {
+			fprintf(stderr, "%s: missing capacity %zu\n", argv[0], i + 1);
+			return 1;
+		}
+
+	if (fwrite(&header, sizeof(header), 1, stdout) != 1 ||
+		fwrite(capacities.data(), sizeof(int), capacities.size(), stdout) != capacities.size() ||
+		fflush(stdout) != 0) {
+		fprintf(stderr, "%s: cannot write the output\n", argv[0]);
+		return 1;
+	}
+
+	return 0;
+
+}
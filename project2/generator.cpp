@@ -0,0 +1,234 @@
+// Generator
+
+/* Rewrite of gerador: for size n, a (2n + 1) x 2n image split by a middle row and column of
+ * weak edges, with one diagonal marker per row of foreground on one half and of background on the
+ * other. ops & 1 swaps foreground and background, ops & 2 adds a base weight to every pixel; with
+ * no noise the output is byte for byte that of gerador.
+ *
+ * A noise above zero adds a random amount in [0, noise] to every pixel weight. Every row has its
+ * own random stream and rows are written in parallel, so the output only depends on the seed,
+ * never on the number of threads */
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*---------------------------------------
+|
+|    Random
+|
+\----------------------------------------*/
+// splitmix64; one independent stream per row
+class Random {
+
+		uint64_t _state;
+
+	public:
+
+		Random(uint64_t seed, uint64_t stream) :
+			_state(seed * 0x9E3779B97F4A7C15ULL + stream * 0xD1B54A32D192ED03ULL) {}
+
+		uint64_t next() {
+			uint64_t z = (_state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+		// Uniform in [0, n)
+		int below(int n) { return (int) (next() % (uint64_t) n); }
+
+};
+
+/*---------------------------------------
+|
+|    Generator
+|
+\----------------------------------------*/
+class Generator {
+
+		enum Matrix { FOREGROUND, BACKGROUND, HORIZONTAL, VERTICAL };
+
+		int      _size;
+		int      _ops;
+		int      _noise;
+		uint64_t _seed;
+
+		static void append(std::string &text, int value) {
+			char buffer[12];
+			int i = sizeof(buffer);
+			do {
+				buffer[--i] = '0' + value % 10;
+				value /= 10;
+			} while (value > 0);
+			text.append(buffer + i, sizeof(buffer) - i);
+		}
+
+		int rows() const { return 2 * _size + 1; }
+		int columns() const { return 2 * _size; }
+
+		// Column of the marker of row i on the left half, mirrored on the right; none on the middle row
+		int marker(int i, bool left) const {
+			if (i == _size)
+				return -1;
+			int j = abs(i - _size) - 1;
+			return left ? j : columns() - 1 - j;
+		}
+
+		int pixel(Matrix matrix, int i, int j) const {
+			bool foreground = (matrix == FOREGROUND) != ((_ops & 1) != 0);
+			int base = (_ops & 2) ? (foreground ? 2 : 1) : 0;
+			return base + (j == marker(i, foreground));
+		}
+
+		int capacity(Matrix matrix, int i, int j) const {
+			int n = _size;
+			if (matrix == HORIZONTAL) {
+				if (i == n)
+					return j == n - 1 ? n : 0;
+				return j == n - 1 ? 0 : 2 * n;
+			}
+			if (i == n - 1 || i == n)
+				return (j == n - 1 || j == n) ? 2 * n : 0;
+			return 2 * n;
+		}
+
+		void row(Matrix matrix, int i, std::string &text) {
+			Random random(_seed, (uint64_t) matrix * rows() + i);
+			int width = matrix == HORIZONTAL ? columns() - 1 : columns();
+			int height = matrix == VERTICAL ? rows() - 1 : rows();
+
+			for (int j = 0; j < width; j++) {
+				if (matrix == FOREGROUND || matrix == BACKGROUND)
+					append(text, pixel(matrix, i, j) + (_noise > 0 ? random.below(_noise + 1) : 0));
+				else
+					append(text, capacity(matrix, i, j));
+				text += ' ';
+			}
+			text += '\n';
+			if (i == height - 1)
+				text += '\n';
+		}
+
+	public:
+
+		Generator(int size, int ops, int noise = 0, uint64_t seed = 0) :
+			_size(size),
+			_ops(ops),
+			_noise(noise),
+			_seed(seed) {}
+
+		// Same restrictions as gerador
+		const char *check() const {
+			if (_size < 2)
+				return "n must be at least 2";
+			if (_ops < 0 || _noise < 0)
+				return "parameters out of range";
+			return NULL;
+		}
+
+		/* Text of the whole input in order, one string per row; threads <= 0 uses every
+		 * core */
+		void generate(std::vector<std::string> &chunks, int threads = 0) {
+			int m = rows();
+			int total = 4 * m - 1;
+			std::atomic<int> next(0);
+			std::vector<std::thread> workers;
+
+			chunks.assign(total + 1, std::string());
+			chunks[0] += std::to_string(m) + " " + std::to_string(columns()) + "\n\n";
+
+			auto work = [&]() {
+				for (int c = next++; c < total; c = next++) {
+					Matrix matrix = (Matrix) std::min(c / m, (int) VERTICAL);
+					row(matrix, c - matrix * m, chunks[c + 1]);
+				}
+			};
+
+			if (threads <= 0)
+				threads = std::max(1u, std::thread::hardware_concurrency());
+			for (int i = 1; i < threads; i++)
+				workers.push_back(std::thread(work));
+			work();
+			for (std::thread &w : workers)
+				w.join();
+		}
+
+		std::string text(int threads = 0) {
+			std::vector<std::string> chunks;
+			std::string all;
+			size_t size = 0;
+
+			generate(chunks, threads);
+			for (const std::string &c : chunks)
+				size += c.size();
+			all.reserve(size);
+			for (const std::string &c : chunks)
+				all += c;
+			return all;
+		}
+
+		void write(FILE *out, int threads = 0) {
+			std::vector<std::string> chunks;
+
+			generate(chunks, threads);
+			for (const std::string &c : chunks)
+				fwrite(c.data(), 1, c.size(), out);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    main
+|
+\----------------------------------------*/
+#ifndef GENERATOR_NO_MAIN
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-j threads] n ops [noise [seed]] > input\n", name);
+	fprintf(stderr, " n          : the image is (2n + 1) x 2n; at least 2\n");
+	fprintf(stderr, " ops        : ops & 1 swaps foreground and background, ops & 2 makes short paths\n");
+	fprintf(stderr, " noise      : random weight in [0, noise] added to every pixel (default 0, as gerador)\n");
+	fprintf(stderr, " seed       : seed for the random streams (default 0)\n");
+	fprintf(stderr, " -j threads : threads writing the rows; 0 uses every core (default)\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {
+
+	int threads = 0;
+	std::vector<long long> params;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (argv[i][0] == '-')
+			usage(argv[0]);
+		else
+			params.push_back(atoll(argv[i]));
+	}
+
+	if (params.size() < 2 || params.size() > 4)
+		usage(argv[0]);
+
+	Generator gen(params[0], params[1],
+		params.size() > 2 ? params[2] : 0,
+		params.size() > 3 ? params[3] : 0);
+
+	if (gen.check() != NULL) {
+		fprintf(stderr, "%s: %s\n", argv[0], gen.check());
+		usage(argv[0]);
+	}
+
+	gen.write(stdout, threads);
+
+	return 0;
+
+}
+#endif
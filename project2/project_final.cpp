@@ -3,10 +3,36 @@
 #include <vector>
 #include <queue>
 #include <stack>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <atomic>
+#include <chrono>
 
 #include <climits>
+#include <cstring>
 #include <iostream>
 
+#include <malloc.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <stdexcept>
+
+#include "../common/profile.h"
+#include "../common/server.h"
+#include "../common/batch.h"
+
+/* Input that breaks the format; the run that reads it fails, and only that one, so the server
+ * and batch modes go on with the next job */
+struct BadInput : std::runtime_error {
+	BadInput(const std::string &what) : std::runtime_error(what) {}
+};
+
 /*---------------------------------------
 |
 |    Vertex
@@ -67,8 +93,9 @@ class Edge {
 		inline Vertex *source() const { return _source; }
 		inline Vertex *target() const { return _target; }
 
-		inline int cap()  const { return _capacity; }
-		inline int flow() const { return _flow;     }
+		inline int cap()      const { return _capacity;         }
+		inline int flow()     const { return _flow;             }
+		inline int residual() const { return _capacity - _flow; }
 		
 		inline Edge *rev()   const { return _rev; }
 		inline bool hasRev() const { return _rev != NULL; }
@@ -117,7 +144,7 @@ class Graph {
 		inline Vertex *vertex(int key) const {
 			if (key >= 0 && key < _vertexNo)
 				return _vertices[key];
-			exit(1);
+			throw BadInput("vertex " + std::to_string(key) + " out of range");
 		}
 
 		Vertex *source() const { return vertex(0); }
@@ -126,6 +153,14 @@ class Graph {
 		bool fromSource(Edge *e) const { return e->source()->key() == source()->key(); }
 		bool toTarget(Edge *e)   const { return e->target()->key() == target()->key(); }
 
+		/* Since edge (v, t) is added first, it is always at 0, if it exists */
+		Edge *targetEdge(Vertex *v) const {
+			const std::vector<Edge*> &adj = adjacency(v);
+			if (adj.size() > 0 && toTarget(adj[0]))
+				return adj[0];
+			return NULL;
+		}
+
 		inline const int size() const { return _vertexNo; }
 
 		//-----------------------------------------------------------------------
@@ -134,7 +169,7 @@ class Graph {
 			if (v->isValid())
 				_vertices[v->key()] = v;
 			else
-				exit(1);
+				throw BadInput("vertex " + std::to_string(v->key()) + " out of range");
 		}
 
 		void addEdge(Edge *e) {
@@ -153,8 +188,9 @@ class Graph {
 			addVertex(new Vertex(key));
 		}
 
-		void loadSingleEdge(Vertex *s, Vertex *t, int cap) {
-			if (cap == 0)
+		/* Empty edges are kept only when their capacity may grow later on */
+		void loadSingleEdge(Vertex *s, Vertex *t, int cap, bool keepEmpty = false) {
+			if (cap == 0 && !keepEmpty)
 				return;
 			addEdge(new Edge(s, t, cap));
 		}
@@ -171,50 +207,708 @@ class Graph {
 			setReverse(normal, reverse);
 		}
 
+		/* Takes the m x n image from next(), which returns every capacity in turn: source
+		 * capacities, sink capacities, then horizontal and vertical neighbour capacities;
+		 * creation of objects */
+		template <class Next>
+		void loadCapacities(Next next, int m, int n, bool keepEmpty) {
+			for (int i = 0; i < _vertexNo; i++)
+				loadVertex(i);
+
+			for (int i = 1; i < _vertexNo - 1; i++)
+				loadSingleEdge(source(), vertex(i), next(), keepEmpty);
+
+			for (int i = 1; i < _vertexNo - 1; i++)
+				loadSingleEdge(vertex(i), target(), next(), keepEmpty);
+
+			for (int i = 1; i < _vertexNo - 1; i++) {
+				if (i % n == 0)
+					continue;
+				loadDoubleEdge(vertex(i), vertex(i + 1), next());
+			}
+
+			for (int i = 1; i < n * (m - 1) + 1; i++)
+				loadDoubleEdge(vertex(i), vertex(i + n), next());
+		}
+
+		// Reads the image after its text header
+		void load(FILE *in, int m, int n, bool keepEmpty = false) {
+			loadCapacities([in]() {
+				int capacity;
+				if (fscanf(in, "%d", &capacity) != 1)
+					throw BadInput("capacity missing");
+				return capacity;
+			}, m, n, keepEmpty);
+		}
+
+		// Takes the image from the capacities of a binary input, in the same order
+		void load(const int *capacities, int m, int n, bool keepEmpty = false) {
+			loadCapacities([&capacities]() { return *capacities++; }, m, n, keepEmpty);
+		}
+
+		// Deletion of objects; whatever a failed load created goes with the graph
 		void unload() {
-			for (Vertex *v : _vertices) {
-				for (Edge *e : _edges[v->key()])
+			for (std::vector<Edge*> &adj : _edges)
+				for (Edge *e : adj)
 					delete e;
-			delete v;
+			for (Vertex *v : _vertices)
+				delete v;
+			_edges.clear();
+			_vertices.clear();
+		}
+
+		~Graph() { unload(); }
+
+		// Bytes held by each structure; the edges, with capacity and flow, are the residual graph
+		std::vector< std::pair<std::string, size_t> > memory() const {
+			std::vector< std::pair<std::string, size_t> > usage;
+			size_t edges = 0;
+			size_t adjacency = _edges.capacity() * sizeof(std::vector<Edge*>);
+
+			for (const std::vector<Edge*> &adj : _edges) {
+				edges += adj.size() * sizeof(Edge);
+				adjacency += adj.capacity() * sizeof(Edge*);
 			}
+
+			usage.push_back(std::make_pair("vertices", _vertices.capacity() * sizeof(Vertex*) + _vertexNo * sizeof(Vertex)));
+			usage.push_back(std::make_pair("residualGraph", edges));
+			usage.push_back(std::make_pair("adjacency", adjacency));
+			return usage;
 		}
 
-		void output(int n) {
+		// Source side of the last cut found, one entry per vertex
+		std::vector<char> cut() const {
+			std::vector<char> side(_vertexNo);
+			for (int i = 0; i < _vertexNo; i++)
+				side[i] = vertex(i)->visited();
+			return side;
+		}
+
+		void output(int n, FILE *out = stdout) {
+			output(n, cut(), out);
+		}
+
+		void output(int n, const std::vector<char> &side, FILE *out = stdout) {
 			for (int i = 1; i < _vertexNo - 1; i++) {
-				if (vertex(i)->visited())
-					fprintf(stdout, "C ");
+				if (side[i])
+					fprintf(out, "C ");
 				else
-					fprintf(stdout, "P ");
+					fprintf(out, "P ");
 				if (i % n == 0)
-					fprintf(stdout, "\n");
+					fprintf(out, "\n");
+			}
+		}
+};
+
+/*---------------------------------------
+|
+|    Mapping
+|
+\----------------------------------------*/
+/* The bytes of a binary input. A regular file read from its start is mapped and faulted in at
+ * once, so it is used where it lies in the page cache; any other stream (pipe, socket) is copied,
+ * reading exactly the size of the input and no further */
+class Mapping {
+
+		const char        *_data;
+		size_t             _size;
+		bool               _mapped;
+		std::vector<char>  _copy;
+
+	public:
+
+		// The first done bytes, the header, were already read from in into header
+		Mapping(FILE *in, const void *header, size_t done, size_t size) :
+			_data(NULL),
+			_size(size),
+			_mapped(false) {
+			struct stat info;
+
+			if (fstat(fileno(in), &info) == 0 && S_ISREG(info.st_mode) &&
+				(size_t) info.st_size >= size && ftell(in) == (long) done) {
+				void *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fileno(in), 0);
+				if (data != MAP_FAILED) {
+					_data = (const char *) data;
+					_mapped = true;
+					return;
+				}
+			}
+
+			_copy.resize(size);
+			memcpy(_copy.data(), header, done);
+			if (fread(_copy.data() + done, 1, size - done, in) != size - done)
+				throw BadInput("binary input shorter than its header says");
+			_data = _copy.data();
+		}
+
+		~Mapping() {
+			if (_mapped)
+				munmap((void *) _data, _size);
+		}
+
+		const char *data() const { return _data; }
+		size_t size()      const { return _size; }
+
+};
+
+/* Binary input, as written by convert: the header below, then every capacity of the text format
+ * in the same order as native ints */
+struct ImageHeader {
+	char magic[4];      // "SEG1"
+	int  m;
+	int  n;
+
+	bool valid() const { return !memcmp(magic, "SEG1", 4) && m > 0 && n > 0 && (long long) m * n <= INT_MAX / 8; }
+
+	size_t capacities() const { return 2 * (size_t) m * n + (size_t) m * (n - 1) + (size_t) (m - 1) * n; }
+
+	size_t bytes() const { return sizeof(ImageHeader) + capacities() * sizeof(int); }
+};
+
+/*---------------------------------------
+|
+|    DisjointSets
+|
+\----------------------------------------*/
+class DisjointSets {
+
+		std::vector<int> _parent;
+		std::vector<int> _size;
+
+	public:
+
+		DisjointSets(int n) :
+			_parent(n),
+			_size(n, 1) {
+			for (int i = 0; i < n; i++)
+				_parent[i] = i;
+		}
+
+		// Path halving
+		int find(int x) {
+			while (_parent[x] != x) {
+				_parent[x] = _parent[_parent[x]];
+				x = _parent[x];
+			}
+			return x;
+		}
+
+		// Union by size
+		void unite(int a, int b) {
+			a = find(a);
+			b = find(b);
+			if (a == b)
+				return;
+			if (_size[a] < _size[b])
+				std::swap(a, b);
+			_parent[b] = a;
+			_size[a] += _size[b];
+		}
+
+};
+
+/*---------------------------------------
+|
+|    ThreadPool
+|
+\----------------------------------------*/
+class ThreadPool {
+
+		std::vector<std::thread>             _workers;
+		std::queue< std::function<void()> > _tasks;
+		std::mutex                           _mutex;
+		std::condition_variable              _ready;
+		std::condition_variable              _idle;
+		int                                  _pending;
+		bool                                 _stop;
+
+		void work() {
+			for (;;) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(_mutex);
+					_ready.wait(lock, [this] { return _stop || !_tasks.empty(); });
+					if (_tasks.empty())
+						return;
+					task = std::move(_tasks.front());
+					_tasks.pop();
+				}
+				task();
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (--_pending == 0)
+						_idle.notify_all();
+				}
+			}
+		}
+
+	public:
+
+		ThreadPool(int n) :
+			_pending(0),
+			_stop(false) {
+			if (n <= 0)
+				n = defaultSize();
+			for (int i = 0; i < n; i++)
+				_workers.emplace_back(&ThreadPool::work, this);
+		}
+
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_stop = true;
+			}
+			_ready.notify_all();
+			for (std::thread &t : _workers)
+				t.join();
+		}
+
+		static int defaultSize() {
+			int n = std::thread::hardware_concurrency();
+			return n > 0 ? n : 1;
+		}
+
+		inline int size() const { return _workers.size(); }
+
+		void submit(std::function<void()> task) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				_tasks.push(std::move(task));
+				_pending++;
+			}
+			_ready.notify_one();
+		}
+
+		// Blocks until every submitted task has finished
+		void wait() {
+			std::unique_lock<std::mutex> lock(_mutex);
+			_idle.wait(lock, [this] { return _pending == 0; });
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Pseudoflow
+|
+\----------------------------------------*/
+/* Hochbaum's pseudoflow, highest label first with FIFO buckets. Every source and sink edge is
+ * saturated up front and the resulting excesses and deficits are merged along interior edges, as
+ * trees hanging from strong (excess) and weak roots, until a gap lifts every strong tree to the
+ * source side. Excess that cannot reach the sink is left where it is: only the cut is exact, the
+ * flow is recovered from it by MinCutMaxFlow::cut(). Any pseudoflow already on the edges is
+ * taken as the starting point. */
+class Pseudoflow {
+
+		Graph &_graph;
+		int    _nodes;  // source and sink included; also the label of lifted nodes
+		int    _highest;
+
+		std::vector<int>   _label;
+		std::vector<int>   _excess;
+		std::vector<int>   _parent;
+		std::vector<Edge*> _toParent;  // oriented from the node to its parent
+		std::vector<int>   _child;     // first child
+		std::vector<int>   _sibling;
+		std::vector<int>   _nextScan;  // child the tree traversal resumes from
+		std::vector<int>   _nextArc;   // adjacency entries before it are not admissible
+		std::vector<int>   _labelCount;
+		std::vector<int>   _bucketStart;
+		std::vector<int>   _bucketEnd;
+		std::vector<int>   _bucketNext;
+
+		void addToBucket(int u) {
+			int l = _label[u];
+			_bucketNext[u] = -1;
+			if (_bucketStart[l] == -1)
+				_bucketStart[l] = u;
+			else
+				_bucketNext[_bucketEnd[l]] = u;
+			_bucketEnd[l] = u;
+		}
+
+		int popBucket(int l) {
+			int u = _bucketStart[l];
+			_bucketStart[l] = _bucketNext[u];
+			_bucketNext[u] = -1;
+			return u;
+		}
+
+		void addRelationship(int parent, int child) {
+			_parent[child]  = parent;
+			_sibling[child] = _child[parent];
+			_child[parent]  = child;
+		}
+
+		void breakRelationship(int parent, int child) {
+			_parent[child] = -1;
+			if (_child[parent] == child)
+				_child[parent] = _sibling[child];
+			else {
+				int c = _child[parent];
+				while (_sibling[c] != child)
+					c = _sibling[c];
+				_sibling[c] = _sibling[child];
+			}
+			_sibling[child] = -1;
+		}
+
+		// Re-roots the tree of child at child and hangs it from parent through arc
+		void merge(int parent, int child, Edge *arc) {
+			int current = child;
+			int newParent = parent;
+			while (_parent[current] != -1) {
+				Edge *old = _toParent[current];
+				int oldParent = _parent[current];
+				_toParent[current] = arc;
+				breakRelationship(oldParent, current);
+				addRelationship(newParent, current);
+				newParent = current;
+				current = oldParent;
+				arc = old->rev();
+			}
+			_toParent[current] = arc;
+			addRelationship(newParent, current);
+		}
+
+		// Pushes the excess of a strong root up to the root of its new tree, splitting at saturated edges
+		void pushExcess(int root) {
+			int current;
+			int parent;
+			int prevExcess = 1;
+
+			for (current = root; _excess[current] != 0 && _parent[current] != -1; current = parent) {
+				Edge *e = _toParent[current];
+				int res = e->residual();
+				int df  = res < _excess[current] ? res : _excess[current];
+
+				parent = _parent[current];
+				prevExcess = _excess[parent];
+
+				e->addFlow(df);
+				e->rev()->subFlow(df);
+				_excess[parent]  += df;
+				_excess[current] -= df;
+
+				if (_excess[current] > 0) {
+					breakRelationship(parent, current);
+					addToBucket(current);
+					_nextArc[parent] = 0;
+				}
+			}
+
+			if (_excess[current] > 0 && prevExcess <= 0)
+				addToBucket(current);
+		}
+
+		// Interior edge from u to a node one label below, with residual capacity
+		int findWeakNode(int u, Edge *&arc) {
+			const std::vector<Edge*> &adj = _graph.adjacency(_graph.vertex(u));
+			int size = adj.size();
+
+			for (int i = _nextArc[u]; i < size; i++) {
+				Edge *e = adj[i];
+				int w = e->target()->key();
+				if (_label[w] == _highest - 1 && e->residual() > 0 && !_graph.toTarget(e)) {
+					_nextArc[u] = i;
+					arc = e;
+					return w;
+				}
+			}
+			_nextArc[u] = size;
+			return -1;
+		}
+
+		// Relabels u unless one of its remaining children shares its label
+		void checkChildren(int u) {
+			for (; _nextScan[u] != -1; _nextScan[u] = _sibling[_nextScan[u]])
+				if (_label[_nextScan[u]] == _label[u])
+					return;
+			_labelCount[_label[u]]--;
+			_label[u]++;
+			_labelCount[_label[u]]++;
+			_nextArc[u] = 0;
+		}
+
+		void lift(int u) {
+			_labelCount[_label[u]]--;
+			_label[u] = _nodes;
+			_nextScan[u] = _child[u];
+		}
+
+		// Moves a whole tree to the source side
+		void liftAll(int root) {
+			lift(root);
+			for (int u = root; u != -1; u = _parent[u]) {
+				while (_nextScan[u] != -1) {
+					int c = _nextScan[u];
+					_nextScan[u] = _sibling[c];
+					u = c;
+					lift(u);
+				}
+			}
+		}
+
+		int highestStrongRoot() {
+			for (int l = _highest; l > 0; l--) {
+				if (_bucketStart[l] != -1) {
+					_highest = l;
+					if (_labelCount[l - 1] > 0)
+						return popBucket(l);
+					// Gap: nothing below can be reached any more
+					while (_bucketStart[l] != -1)
+						liftAll(popBucket(l));
+				}
+			}
+
+			if (_bucketStart[0] == -1)
+				return -1;
+
+			while (_bucketStart[0] != -1) {
+				int u = popBucket(0);
+				_label[u] = 1;
+				_labelCount[0]--;
+				_labelCount[1]++;
+				addToBucket(u);
+			}
+
+			_highest = 1;
+			return popBucket(1);
+		}
+
+		void processRoot(int root) {
+			Edge *arc;
+			int w;
+			int u = root;
+
+			_nextScan[root] = _child[root];
+
+			if ((w = findWeakNode(root, arc)) != -1) {
+				merge(w, root, arc);
+				pushExcess(root);
+				return;
+			}
+
+			checkChildren(root);
+
+			// Depth first over the nodes sharing the root label
+			while (u != -1) {
+				while (_nextScan[u] != -1) {
+					int c = _nextScan[u];
+					_nextScan[u] = _sibling[c];
+					u = c;
+					_nextScan[u] = _child[u];
+
+					if ((w = findWeakNode(u, arc)) != -1) {
+						merge(w, u, arc);
+						pushExcess(root);
+						return;
+					}
+
+					checkChildren(u);
+				}
+
+				if ((u = _parent[u]) != -1)
+					checkChildren(u);
+			}
+
+			addToBucket(root);
+			_highest++;
+		}
+
+	public:
+
+		Pseudoflow(Graph &g) :
+			_graph(g),
+			_nodes(g.size()),
+			_highest(1),
+			_label(_nodes, 0),
+			_excess(_nodes, 0),
+			_parent(_nodes, -1),
+			_toParent(_nodes, NULL),
+			_child(_nodes, -1),
+			_sibling(_nodes, -1),
+			_nextScan(_nodes, -1),
+			_nextArc(_nodes, 0),
+			_labelCount(_nodes + 1, 0),
+			_bucketStart(_nodes + 1, -1),
+			_bucketEnd(_nodes + 1, -1),
+			_bucketNext(_nodes, -1) {}
+
+		void run() {
+			for (Edge *e : _graph.adjacency(_graph.source())) {
+				e->addFlow(e->residual());
+				_excess[e->target()->key()] += e->flow();
+			}
+
+			for (int i = 1; i < _nodes - 1; i++) {
+				Edge *t = _graph.targetEdge(_graph.vertex(i));
+				if (t != NULL)
+					t->addFlow(t->residual());
+				for (Edge *e : _graph.adjacency(_graph.vertex(i)))
+					_excess[i] -= e->flow();
+
+				if (_excess[i] > 0) {
+					_label[i] = 1;
+					addToBucket(i);
+				}
+				_labelCount[_label[i]]++;
+			}
+
+			int root;
+			while ((root = highestStrongRoot()) != -1)
+				processRoot(root);
+		}
+
+};
+
+/*---------------------------------------
+|
+|    Telemetry
+|
+\----------------------------------------*/
+/* Counters of the max-flow engines, compiled in with -DMAXFLOW_TELEMETRY and written to stderr as
+ * JSON at exit. Histograms have power of two buckets, keyed by their lower bound. Without the macro
+ * TELEMETRY(...) expands to nothing and the engines are unchanged */
+#ifdef MAXFLOW_TELEMETRY
+#define TELEMETRY(statement) statement
+
+class Telemetry {
+
+		static const int BUCKETS = 32;
+
+		std::atomic<long long> _solves;
+		std::atomic<long long> _augmentations;
+		std::atomic<long long> _searches;
+		std::atomic<long long> _visited;
+		std::atomic<long long> _startingFlow;
+		std::atomic<long long> _mainFlow;
+
+		std::atomic<long long> _pathLength[BUCKETS];
+		std::atomic<long long> _bottleneck[BUCKETS];
+		std::atomic<long long> _coverage[BUCKETS];
+
+		static int bucket(long long value) {
+			int b = 0;
+			while (value > 1 && b < BUCKETS - 1) {
+				value >>= 1;
+				b++;
+			}
+			return b;
+		}
+
+		static void histogram(FILE *out, const char *name, const std::atomic<long long> *h) {
+			bool first = true;
+			fprintf(out, "\t\"%s\": {", name);
+			for (int b = 0; b < BUCKETS; b++) {
+				if (h[b] == 0)
+					continue;
+				fprintf(out, "%s \"%lld\": %lld", first ? "" : ",", 1LL << b, h[b].load());
+				first = false;
+			}
+			fprintf(out, " }");
+		}
+
+	public:
+
+		Telemetry() :
+			_solves(0),
+			_augmentations(0),
+			_searches(0),
+			_visited(0),
+			_startingFlow(0),
+			_mainFlow(0) {
+			for (int b = 0; b < BUCKETS; b++) {
+				_pathLength[b] = 0;
+				_bottleneck[b] = 0;
+				_coverage[b] = 0;
 			}
 		}
+
+		~Telemetry() { json(stderr); }
+
+		void augmented(int length, int bottleneck) {
+			_augmentations++;
+			_pathLength[bucket(length)]++;
+			_bottleneck[bucket(bottleneck)]++;
+		}
+
+		// One search for an augmenting path, and the vertices it reached
+		void searched(int visited) {
+			_searches++;
+			_visited += visited;
+			_coverage[bucket(visited)]++;
+		}
+
+		void startingFlow(int flow) { _startingFlow += flow; }
+
+		void solved(int flow) {
+			_solves++;
+			_mainFlow += flow;
+		}
+
+		void json(FILE *out) const {
+			fprintf(out, "{\n");
+			fprintf(out, "\t\"solves\": %lld,\n", _solves.load());
+			fprintf(out, "\t\"startingFlow\": %lld,\n", _startingFlow.load());
+			fprintf(out, "\t\"mainFlow\": %lld,\n", _mainFlow.load());
+			fprintf(out, "\t\"augmentations\": %lld,\n", _augmentations.load());
+			fprintf(out, "\t\"searches\": %lld,\n", _searches.load());
+			fprintf(out, "\t\"visited\": %lld,\n", _visited.load());
+			histogram(out, "pathLength", _pathLength);
+			fprintf(out, ",\n");
+			histogram(out, "bottleneck", _bottleneck);
+			fprintf(out, ",\n");
+			histogram(out, "visitedPerSearch", _coverage);
+			fprintf(out, "\n}\n");
+		}
+
 };
 
+Telemetry telemetry;
+#else
+#define TELEMETRY(statement)
+#endif
+
 /*---------------------------------------
 |
 |    MinCutMaxFlow
 |
 \----------------------------------------*/
+enum Engine { EDMONDS_KARP, SCALING, BIDIRECTIONAL, PSEUDOFLOW };
+
 class MinCutMaxFlow {
 
 		Graph  &_graph;
 		Vertex *_source;
 		Vertex *_target;
 		int     _maxFlow;
+		Engine  _engine;
+		ThreadPool *_pool;
 
 	public:
 
 
-		MinCutMaxFlow(Graph &g, Vertex *s, Vertex *t) :
+		MinCutMaxFlow(Graph &g, Vertex *s, Vertex *t, Engine engine = EDMONDS_KARP) :
 			_graph(g),
 			_source(s),
 			_target(t),
-			_maxFlow(0) {}
+			_maxFlow(0),
+			_engine(engine),
+			_pool(NULL) {}
 
 
 		int min(int i1, int i2) { return i1 < i2 ? i1 : i2; }
 
+		inline int flow() const { return _maxFlow; }
+
+		void flow(int f) { _maxFlow = f; }
+
+		// Workers owned by the caller for splitSolve, instead of a new pool on every call
+		void pool(ThreadPool *p) { _pool = p; }
+
+		/* Saturates every path s -> v -> t; only residual capacities are used,
+		 * so it may be called again after capacities grow */
 		void addStartingFlow() {
 			Vertex *s = _graph.source();
 			Vertex *t = _graph.target();
@@ -222,26 +916,107 @@ class MinCutMaxFlow {
 			Edge *vt;
 
 			int flow;
+			TELEMETRY(int before = _maxFlow);
 
 			for (Edge *sv : _graph.adjacency(s)) {
 				if (_graph.adjacency(sv->target()).size() > 0) {
 					/* Since edge (v, t) is added first, target is always at 0, if exists */
 					vt = _graph.adjacency(sv->target())[0];
 					if (vt->target() == t) {
-						flow = min(sv->cap(), vt->cap());
+						flow = min(sv->residual(), vt->residual());
 						sv->addFlow(flow);
 						vt->addFlow(flow);
 						_maxFlow += flow;
 					}
 				}
 			}
+			TELEMETRY(telemetry.startingFlow(_maxFlow - before));
+		}
+
+		// Inflow minus outflow of every vertex; zero everywhere but s and t for a proper flow
+		std::vector<int> excesses() const {
+			int size = _graph.size();
+			std::vector<int> excess(size, 0);
+
+			for (Edge *e : _graph.adjacency(_source))
+				excess[e->target()->key()] += e->flow();
+
+			for (int i = 1; i < size - 1; i++)
+				for (Edge *e : _graph.adjacency(_graph.vertex(i)))
+					excess[i] -= e->flow();
+
+			return excess;
+		}
+
+		/* Marks the source side of the minimum cut and sets the flow value from whatever is on the
+		 * edges. Excess left over by a pseudoflow is treated as flow sent back to the source, which
+		 * turns it into a maximum flow of a network with exactly the same cuts: its source side is
+		 * everything reachable from s or from an excess vertex */
+		int cut() {
+			std::vector<int> excess = excesses();
+			std::queue<Vertex*> queue;
+
+			int size = _graph.size();
+			for (int i = 0; i < size; i++)
+				_graph.vertex(i)->level(-1);
+
+			_maxFlow = 0;
+			for (Edge *e : _graph.adjacency(_source))
+				_maxFlow += e->flow();
+
+			queue.push(_source);
+			_source->level(0);
+			for (int i = 1; i < size - 1; i++) {
+				if (excess[i] > 0) {
+					_maxFlow -= excess[i];
+					_graph.vertex(i)->level(0);
+					queue.push(_graph.vertex(i));
+				}
+			}
+
+			while (!queue.empty()) {
+				Vertex *curr = queue.front();
+				queue.pop();
+
+				for (Edge *e : _graph.adjacency(curr)) {
+					if (!e->target()->visited() && e->residual() > 0) {
+						e->target()->level(0);
+						queue.push(e->target());
+					}
+				}
+			}
+			return _maxFlow;
+		}
+
+		int solve() {
+			int flow;
+			TELEMETRY(int before = _maxFlow);
+
+			switch (_engine) {
+				case SCALING:
+					flow = scalingEdmondsKarp();
+					break;
+				case BIDIRECTIONAL:
+					flow = bidirectionalEdmondsKarp();
+					break;
+				case PSEUDOFLOW:
+					flow = pseudoflow();
+					break;
+				default:
+					flow = edmondsKarp();
+			}
+
+			TELEMETRY(telemetry.solved(flow - before));
+			return flow;
 		}
 
 		/* ---------------------------------------------------------------------------------------- */
 		/* E-K methods ---------------------------------------------------------------------------- */
-		bool BFS_ek(std::vector<Edge*> &pred) {
+		// Only edges with at least delta residual capacity are followed
+		bool BFS_ek(std::vector<Edge*> &pred, int delta = 1) {
 
 			std::queue<Vertex*> queue;
+			TELEMETRY(int visited = 0);
 
 			int size = _graph.size();
 			for (int i = 0; i < size; i++) {
@@ -255,32 +1030,471 @@ class MinCutMaxFlow {
 			while (!queue.empty()) {
 				Vertex *curr = queue.front();
 				queue.pop();
+				TELEMETRY(visited++);
 
 				for (Edge *e : _graph.adjacency(curr)) {
-					if (pred[e->target()->key()] == NULL && e->cap() > e->flow()) {
+					if (pred[e->target()->key()] == NULL && e->residual() >= delta) {
 						pred[e->target()->key()] = e;
 						e->target()->level(0);
 						queue.push(e->target());
 					}
 				}
 			}
+			TELEMETRY(telemetry.searched(visited));
 			return _target->visited();
 		}
 
+		/* ---------------------------------------------------------------------------------------- */
+		/* Component splitting -------------------------------------------------------------------- */
+
+		/* Pixels that no augmenting path can cross are decided and left as they are: those that
+		 * cannot be reached from a fed pixel (residual source capacity) or cannot reach a drained
+		 * one (residual sink capacity) over residual edges. Augmenting the others only adds residual
+		 * edges among themselves, so the decided stay decided, and a path never leaves the
+		 * component that the residual edges between undecided pixels join; each component is
+		 * solved on its own small graph. Leftover excess of a pseudoflow feeds its pixel like extra
+		 * source capacity, and deficits drain like sink capacity */
+		int splitSolve(int threads) {
+			int size = _graph.size();
+
+			std::vector<int>   excess = excesses();
+			std::vector<Edge*> sourceEdge(size, NULL);
+			std::vector<char>  reach(size, 0);    // bit 1 reached from a fed pixel, bit 2 reaching a drained one
+			std::vector<int>   forward;
+			std::vector<int>   backward;
+			std::vector<int>   component(size, 0);
+			std::vector<int>   start(size + 1, 0);
+			std::vector<int>   members(size);
+			DisjointSets       sets(size);
+			int                undecided = 0;
+
+			for (Edge *e : _graph.adjacency(_source))
+				sourceEdge[e->target()->key()] = e;
+
+			for (int i = 1; i < size - 1; i++) {
+				Edge *t = _graph.targetEdge(_graph.vertex(i));
+				if (excess[i] > 0 || (sourceEdge[i] != NULL && sourceEdge[i]->residual() > 0)) {
+					reach[i] |= 1;
+					forward.push_back(i);
+				}
+				if (excess[i] < 0 || (t != NULL && t->residual() > 0)) {
+					reach[i] |= 2;
+					backward.push_back(i);
+				}
+			}
+
+			// Forward along residual edges, backward along edges with residual capacity into the pixel
+			for (size_t q = 0; q < forward.size(); q++)
+				for (Edge *e : _graph.adjacency(_graph.vertex(forward[q]))) {
+					int w = e->target()->key();
+					if (!_graph.toTarget(e) && !(reach[w] & 1) && e->residual() > 0) {
+						reach[w] |= 1;
+						forward.push_back(w);
+					}
+				}
+			for (size_t q = 0; q < backward.size(); q++)
+				for (Edge *e : _graph.adjacency(_graph.vertex(backward[q]))) {
+					int w = e->target()->key();
+					if (!_graph.toTarget(e) && !(reach[w] & 2) && e->rev()->residual() > 0) {
+						reach[w] |= 2;
+						backward.push_back(w);
+					}
+				}
+
+			for (int i = 1; i < size - 1; i++)
+				if (reach[i] == 3)
+					for (Edge *e : _graph.adjacency(_graph.vertex(i)))
+						if (!_graph.toTarget(e) && reach[e->target()->key()] == 3 && e->residual() > 0)
+							sets.unite(i, e->target()->key());
+
+			for (int i = 1; i < size - 1; i++)
+				if (reach[i] == 3) {
+					component[i] = sets.find(i);
+					start[component[i] + 1]++;
+					undecided++;
+				}
+
+			// Counting sort of undecided pixels by component root
+			for (int i = 1; i <= size; i++)
+				start[i] += start[i - 1];
+			std::vector<int> next(start.begin(), start.end() - 1);
+			for (int i = 1; i < size - 1; i++)
+				if (reach[i] == 3)
+					members[next[component[i]]++] = i;
+
+			// Every component holds a fed and a drained pixel, those its pixels are reached from and reach
+			std::vector<int> roots;
+			for (int r = 1; r < size - 1; r++)
+				if (reach[r] == 3 && component[r] == r)
+					roots.push_back(r);
+
+			// A single component spanning the whole grid gains nothing from a copy
+			if (roots.size() == 1 && undecided == size - 2)
+				return solve();
+
+			// Local index of every pixel inside its own component graph
+			std::vector<int> local(size, 0);
+			for (int r : roots)
+				for (int j = start[r]; j < start[r + 1]; j++)
+					local[members[j]] = j - start[r] + 1;
+
+			{
+				ThreadPool *own = _pool == NULL ? new ThreadPool(threads) : NULL;
+				ThreadPool &pool = _pool != NULL ? *_pool : *own;
+				for (int r : roots)
+					pool.submit([&, r] {
+						solveComponent(&members[start[r]], start[r + 1] - start[r], excess, sourceEdge, local);
+					});
+				pool.wait();
+				delete own;
+			}
+
+			return cut();
+		}
+
+		/* Builds the residual graph of a single component, solves it and adds its flow back
+		 * onto the edges of the whole graph */
+		void solveComponent(const int *members, int k, const std::vector<int> &excess,
+			const std::vector<Edge*> &sourceEdge, const std::vector<int> &local) {
+
+			Graph sub(k + 2, 0);
+			std::vector<Edge*> subSource(k, NULL);
+			std::vector<Edge*> subTarget(k, NULL);
+			std::vector< std::pair<Edge*, Edge*> > links;
+
+			for (int i = 0; i < k + 2; i++)
+				sub.loadVertex(i);
+
+			for (int j = 0; j < k; j++) {
+				Edge *s = sourceEdge[members[j]];
+				Edge *t = _graph.targetEdge(_graph.vertex(members[j]));
+				int ex = excess[members[j]];
+				int sc = (s != NULL ? s->residual() : 0) + (ex > 0 ?  ex : 0);
+				int tc = (t != NULL ? t->residual() : 0) + (ex < 0 ? -ex : 0);
+				if (sc > 0) {
+					subSource[j] = new Edge(sub.source(), sub.vertex(j + 1), sc);
+					sub.addEdge(subSource[j]);
+				}
+				if (tc > 0) {
+					subTarget[j] = new Edge(sub.vertex(j + 1), sub.target(), tc);
+					sub.addEdge(subTarget[j]);
+				}
+			}
+
+			for (int j = 0; j < k; j++) {
+				for (Edge *e : _graph.adjacency(_graph.vertex(members[j]))) {
+					if (_graph.toTarget(e) || local[e->target()->key()] < j + 1)
+						continue;
+					Edge *normal  = new Edge(sub.vertex(j + 1), sub.vertex(local[e->target()->key()]), e->residual());
+					Edge *reverse = new Edge(normal->target(), normal->source(), e->rev()->residual());
+					sub.addEdge(normal);
+					sub.addEdge(reverse);
+					sub.setReverse(normal, reverse);
+					links.push_back(std::make_pair(normal, e));
+				}
+			}
+
+			MinCutMaxFlow mf(sub, sub.source(), sub.target(), _engine);
+			mf.solve();
+
+			for (std::pair<Edge*, Edge*> &l : links) {
+				l.second->addFlow(l.first->flow());
+				l.second->rev()->subFlow(l.first->flow());
+			}
+
+			// Excess and deficit are used up before the terminal edges themselves
+			for (int j = 0; j < k; j++) {
+				int ex = excess[members[j]];
+				if (subSource[j] != NULL && subSource[j]->flow() > (ex > 0 ? ex : 0))
+					sourceEdge[members[j]]->addFlow(subSource[j]->flow() - (ex > 0 ? ex : 0));
+				if (subTarget[j] != NULL && subTarget[j]->flow() > (ex < 0 ? -ex : 0))
+					_graph.targetEdge(_graph.vertex(members[j]))->addFlow(subTarget[j]->flow() - (ex < 0 ? -ex : 0));
+			}
+
+			sub.unload();
+		}
+
+		void push(Edge *e, int df) {
+			e->addFlow(df);
+			if (!_graph.fromSource(e) && !_graph.toTarget(e))
+				e->rev()->subFlow(df);
+		}
+
+		// Pushes the bottleneck of the path found by the last BFS
+		void augment(std::vector<Edge*> &pred) {
+			int df = INT_MAX;
+			TELEMETRY(int length = 0);
+			for (Edge *e = pred[_target->key()]; e != NULL; e = pred[e->source()->key()]) {
+				df = min(df, e->cap() - e->flow());
+				TELEMETRY(length++);
+			}
+			for (Edge *e = pred[_target->key()]; e != NULL; e = pred[e->source()->key()])
+				push(e, df);
+			_maxFlow += df;
+			TELEMETRY(telemetry.augmented(length, df));
+		}
+
 		int edmondsKarp() {
 			std::vector<Edge*> pred(_graph.size());
-			while (BFS_ek(pred)) {
-				int df = INT_MAX;
-				for (Edge *e = pred[_target->key()]; e != NULL; e = pred[e->source()->key()])
-					df = min(df, e->cap() - e->flow());
-				for (Edge *e = pred[_target->key()]; e != NULL; e = pred[e->source()->key()]) {
-					e->addFlow(df);
-					if (!_graph.fromSource(e) && !_graph.toTarget(e))
-						e->rev()->subFlow(df);
+			while (BFS_ek(pred))
+				augment(pred);
+			return _maxFlow;
+		}
+
+		/* Capacity scaling: each phase only takes paths with at least delta residual capacity
+		 * and then halves delta, for O(E log U) augmentations. The last phase (delta = 1) is
+		 * plain Edmonds-Karp and leaves the cut marked */
+		int scalingEdmondsKarp() {
+			std::vector<Edge*> pred(_graph.size());
+			int top = 0;
+			int delta = 1;
+
+			for (Vertex *v : _graph.vertices())
+				for (Edge *e : _graph.adjacency(v))
+					if (e->residual() > top)
+						top = e->residual();
+
+			while (delta <= top / 2)
+				delta *= 2;
+
+			for (; delta >= 1; delta /= 2)
+				while (BFS_ek(pred, delta))
+					augment(pred);
+			return _maxFlow;
+		}
+
+		/* ---------------------------------------------------------------------------------------- */
+		/* Bidirectional E-K ---------------------------------------------------------------------- */
+
+		/* Grows one search from s over residual edges and one from t over reversed residual edges,
+		 * always expanding a whole layer of the smaller frontier, and stops at the first edge that
+		 * joins them. A vertex belongs to a search only while its stamp equals the current
+		 * generation, so nothing is reset between searches and each one costs about the region it
+		 * explores. The cut is marked by a single full BFS at the end */
+		int bidirectionalEdmondsKarp() {
+			int size = _graph.size();
+
+			std::vector<unsigned> forward(size, 0);
+			std::vector<unsigned> backward(size, 0);
+			std::vector<Edge*>    pred(size, NULL);  // edge into the vertex, towards s
+			std::vector<Edge*>    succ(size, NULL);  // edge out of the vertex, towards t
+			std::vector<Edge*>    sourceEdge(size, NULL);
+			std::vector<Edge*>    targetEdges;
+			std::vector<Vertex*>  forwardFront;
+			std::vector<Vertex*>  backwardFront;
+			std::vector<Vertex*>  next;
+			unsigned              generation = 0;
+
+			for (Edge *e : _graph.adjacency(_source))
+				sourceEdge[e->target()->key()] = e;
+			for (int i = 1; i < size - 1; i++)
+				if (_graph.targetEdge(_graph.vertex(i)) != NULL)
+					targetEdges.push_back(_graph.targetEdge(_graph.vertex(i)));
+
+			for (;;) {
+				Edge *bridge = NULL;
+				TELEMETRY(int visited = 2);
+
+				generation++;
+				forward[_source->key()]  = generation;
+				backward[_target->key()] = generation;
+				forwardFront.assign(1, _source);
+				backwardFront.assign(1, _target);
+
+				// Residual edge into a vertex of the backward search
+				auto reach = [&](Edge *in) {
+					int w = in->source()->key();
+					if (in->residual() <= 0 || backward[w] == generation)
+						return;
+					if (forward[w] == generation)
+						bridge = in;
+					else {
+						backward[w] = generation;
+						succ[w] = in;
+						next.push_back(in->source());
+						TELEMETRY(visited++);
+					}
+				};
+
+				while (bridge == NULL && !forwardFront.empty() && !backwardFront.empty()) {
+					next.clear();
+
+					if (forwardFront.size() <= backwardFront.size()) {
+						for (size_t i = 0; bridge == NULL && i < forwardFront.size(); i++) {
+							for (Edge *e : _graph.adjacency(forwardFront[i])) {
+								int w = e->target()->key();
+								if (e->residual() <= 0 || forward[w] == generation)
+									continue;
+								if (backward[w] == generation) {
+									bridge = e;
+									break;
+								}
+								forward[w] = generation;
+								pred[w] = e;
+								next.push_back(e->target());
+								TELEMETRY(visited++);
+							}
+						}
+						forwardFront.swap(next);
+					}
+					else {
+						for (size_t i = 0; bridge == NULL && i < backwardFront.size(); i++) {
+							Vertex *u = backwardFront[i];
+							if (u == _target) {
+								for (size_t j = 0; bridge == NULL && j < targetEdges.size(); j++)
+									reach(targetEdges[j]);
+								continue;
+							}
+							if (sourceEdge[u->key()] != NULL)
+								reach(sourceEdge[u->key()]);
+							for (Edge *e : _graph.adjacency(u))
+								if (bridge == NULL && !_graph.toTarget(e))
+									reach(e->rev());
+						}
+						backwardFront.swap(next);
+					}
+				}
+
+				TELEMETRY(telemetry.searched(visited));
+				if (bridge == NULL)
+					break;
+
+				int df = bridge->residual();
+				TELEMETRY(int length = 1);
+				for (Edge *e = pred[bridge->source()->key()]; e != NULL; e = pred[e->source()->key()]) {
+					df = min(df, e->residual());
+					TELEMETRY(length++);
 				}
+				for (Edge *e = succ[bridge->target()->key()]; e != NULL; e = succ[e->target()->key()]) {
+					df = min(df, e->residual());
+					TELEMETRY(length++);
+				}
+
+				push(bridge, df);
+				for (Edge *e = pred[bridge->source()->key()]; e != NULL; e = pred[e->source()->key()])
+					push(e, df);
+				for (Edge *e = succ[bridge->target()->key()]; e != NULL; e = succ[e->target()->key()])
+					push(e, df);
 				_maxFlow += df;
+				TELEMETRY(telemetry.augmented(length, df));
+			}
+
+			return cut();
+		}
+
+		/* ---------------------------------------------------------------------------------------- */
+		/* Pseudoflow ----------------------------------------------------------------------------- */
+		int pseudoflow() {
+			Pseudoflow pf(_graph);
+			pf.run();
+			return cut();
+		}
+
+};
+
+/*---------------------------------------
+|
+|    ParametricSweep
+|
+\----------------------------------------*/
+/* Foreground bias lambda: lambda > 0 adds lambda to every edge (v, t), lambda < 0 adds -lambda to
+ * every edge (s, v). Moving away from lambda = 0 in either direction capacities only grow, so the
+ * flow of one step is still feasible for the next one and only the new augmenting paths are
+ * searched for; the cuts found along each direction are nested. */
+class ParametricSweep {
+
+		Graph              &_graph;
+		MinCutMaxFlow      &_mf;
+		int                 _threads;
+
+		std::vector<Edge*>  _sourceEdges;
+		std::vector<Edge*>  _targetEdges;
+		int                 _lambda;
+
+		static int positive(int x) { return x > 0 ? x : 0; }
+
+		// Moves every terminal capacity from the current lambda to l
+		void shift(int l) {
+			int ds = positive(-l) - positive(-_lambda);
+			int dt = positive(l)  - positive(_lambda);
+			if (ds != 0)
+				for (Edge *e : _sourceEdges)
+					e->cap(ds);
+			if (dt != 0)
+				for (Edge *e : _targetEdges)
+					e->cap(dt);
+			_lambda = l;
+		}
+
+		void solve() {
+			_mf.addStartingFlow();
+			if (_threads >= 0)
+				_mf.splitSolve(_threads);
+			else
+				_mf.solve();
+		}
+
+		std::vector<int> snapshot() const {
+			std::vector<int> flows;
+			for (Vertex *v : _graph.vertices())
+				for (Edge *e : _graph.adjacency(v))
+					flows.push_back(e->flow());
+			return flows;
+		}
+
+		void restore(const std::vector<int> &flows) {
+			size_t i = 0;
+			for (Vertex *v : _graph.vertices())
+				for (Edge *e : _graph.adjacency(v))
+					e->addFlow(flows[i++] - e->flow());
+		}
+
+	public:
+
+		ParametricSweep(Graph &g, MinCutMaxFlow &mf, int threads) :
+			_graph(g),
+			_mf(mf),
+			_threads(threads),
+			_lambda(0) {
+			for (Edge *e : _graph.adjacency(_graph.source()))
+				_sourceEdges.push_back(e);
+			for (int i = 1; i < _graph.size() - 1; i++) {
+				Edge *e = _graph.targetEdge(_graph.vertex(i));
+				if (e != NULL)
+					_targetEdges.push_back(e);
+			}
+		}
+
+		/* Solves for every lambda, in any order; flows[i] and cuts[i] belong to lambdas[i].
+		 * Terminal edges must have been loaded even when empty */
+		void run(const std::vector<int> &lambdas, std::vector<int> &flows, std::vector< std::vector<char> > &cuts) {
+			std::vector<int> up;
+			std::vector<int> down;
+
+			flows.assign(lambdas.size(), 0);
+			cuts.assign(lambdas.size(), std::vector<char>());
+
+			for (size_t i = 0; i < lambdas.size(); i++)
+				(lambdas[i] >= 0 ? up : down).push_back(i);
+
+			std::sort(up.begin(), up.end(), [&](int a, int b) { return lambdas[a] < lambdas[b]; });
+			std::sort(down.begin(), down.end(), [&](int a, int b) { return lambdas[a] > lambdas[b]; });
+
+			solve();
+			std::vector<int> base = snapshot();
+			int baseFlow = _mf.flow();
+
+			for (std::vector<int> *direction : { &up, &down }) {
+				for (int i : *direction) {
+					shift(lambdas[i]);
+					solve();
+					flows[i] = _mf.flow();
+					cuts[i]  = _graph.cut();
+				}
+				shift(0);
+				restore(base);
+				_mf.flow(baseFlow);
 			}
-			return _maxFlow;
 		}
 
 };
@@ -290,17 +1504,87 @@ class MinCutMaxFlow {
 |    main
 |
 \----------------------------------------*/
-int main() {
+bool parseEngine(const char *name, Engine &engine) {
+	if (!strcmp(name, "ek"))
+		engine = EDMONDS_KARP;
+	else if (!strcmp(name, "scaling"))
+		engine = SCALING;
+	else if (!strcmp(name, "bidir"))
+		engine = BIDIRECTIONAL;
+	else if (!strcmp(name, "pseudo"))
+		engine = PSEUDOFLOW;
+	else
+		return false;
+	return true;
+}
+
+#ifndef PROJECT_NO_MAIN
+void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-e engine] [-j threads] [-l lambda,...] [-p] [-P file] [-s socket] < input\n", name);
+	fprintf(stderr, "       %s [options] -b outdir [-w workers] input|dir...\n", name);
+	fprintf(stderr, " -e engine  : ek (Edmonds-Karp, default), scaling (capacity scaling Edmonds-Karp),\n");
+	fprintf(stderr, "              bidir (bidirectional Edmonds-Karp) or pseudo (Hochbaum's pseudoflow)\n");
+	fprintf(stderr, " -j threads : solve independent components in parallel; 0 uses every core\n");
+	fprintf(stderr, " -l lambdas : foreground bias sweep; one output per lambda, in the given order,\n");
+	fprintf(stderr, "              separated by an empty line\n");
+	fprintf(stderr, " -p         : wall time and hardware counters of every phase, as a table on stderr\n");
+	fprintf(stderr, " -P file    : the same, as JSON in file\n");
+	fprintf(stderr, " input      : text, or binary from convert\n");
+	fprintf(stderr, " -s socket  : stay up and serve inputs sent to a Unix socket, each answered on its\n");
+	fprintf(stderr, "              connection; only the -j workers are kept warm between inputs, every graph\n");
+	fprintf(stderr, "              is built afresh; SIGINT or SIGTERM stops the server\n");
+	fprintf(stderr, " -b outdir  : batch; every input file, and every .in file of every dir, is solved into\n");
+	fprintf(stderr, "              outdir/name.out, several at once\n");
+	fprintf(stderr, " -w workers : files solved at once in batch mode; 0 uses every core (default)\n");
+	exit(1);
+}
+#endif
+
+// Comma separated list of integers; false on anything else, a value out of the range of int included
+bool parseList(const char *str, std::vector<int> &list) {
+	char *end;
+	do {
+		errno = 0;
+		long value = strtol(str, &end, 10);
+		if (end == str || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+			return false;
+		list.push_back(value);
+		str = end + 1;
+	} while (*end == ',');
+	return *end == '\0';
+}
+
+struct Settings {
+	Engine           engine;
+	int              threads;
+	std::vector<int> lambdas;
+	ThreadPool      *pool;      // kept across runs by the server; NULL otherwise
+};
+
+// One whole run, from the input in to the output out; binary inputs open with their magic
+void process(FILE *in, FILE *out, const Settings &settings, Profiler &profiler) {
 
 	int n;
 	int m;
 	int vertexNo;
 	int edgeNo;
 
-	int capacity;
+	ImageHeader header;
+	Mapping *mapping = NULL;
 
 	// Reading input; creation of objects
-	fscanf(stdin, "%d %d", &m, &n);
+	int c = getc(in);
+	ungetc(c, in);
+	if (c == 'S') {
+		if (fread(&header, sizeof(header), 1, in) != 1 || !header.valid())
+			throw BadInput("bad binary header");
+		m = header.m;
+		n = header.n;
+		mapping = new Mapping(in, &header, sizeof(header), header.bytes());
+	}
+	// The graph has about 6mn edges, counted in ints
+	else if (fscanf(in, "%d %d", &m, &n) != 2 || m < 1 || n < 1 || (long long) m * n > INT_MAX / 8)
+		throw BadInput("bad header");
 
 	vertexNo = n * m + 2;
 
@@ -312,42 +1596,152 @@ int main() {
 
 	Graph g(vertexNo, edgeNo);
 
-	for (int i = 0; i < vertexNo; i++)
-		g.loadVertex(i);
+	if (mapping != NULL) {
+		g.load((const int *) (mapping->data() + sizeof(ImageHeader)), m, n, !settings.lambdas.empty());
+		delete mapping;
+	}
+	else
+		g.load(in, m, n, !settings.lambdas.empty());
+
+	MinCutMaxFlow mf(g, g.source(), g.target(), settings.engine);
+	mf.pool(settings.pool);
+	profiler.lap("load");
+
+	if (profiler.enabled())
+		profiler.structures(g.memory());
+
+	// Main procedure
+	if (!settings.lambdas.empty()) {
+		const std::vector<int> &lambdas = settings.lambdas;
+		std::vector<int> flows;
+		std::vector< std::vector<char> > cuts;
+		ParametricSweep sweep(g, mf, settings.threads);
+		sweep.run(lambdas, flows, cuts);
+		profiler.lap("sweep");
+
+		for (size_t i = 0; i < lambdas.size(); i++) {
+			if (i > 0)
+				fprintf(out, "\n");
+			fprintf(out, "%d\n\n", flows[i]);
+			g.output(n, cuts[i], out);
+		}
+	}
+	else {
+		mf.addStartingFlow();
+		profiler.lap("startingFlow");
 
-	MinCutMaxFlow mf(g, g.source(), g.target());
+		fprintf(out, "%d\n\n", settings.threads >= 0 ? mf.splitSolve(settings.threads) : mf.solve());
+		profiler.lap("solve");
 
-	for (int i = 1; i < vertexNo - 1; i++) {
-		fscanf(stdin, "%d", &capacity);
-		g.loadSingleEdge(g.source(), g.vertex(i), capacity);
+		g.output(n, out);
 	}
+	fflush(out);
+	profiler.lap("output");
+
+	// Deletion of objects
+	g.unload();
+	profiler.lap("unload");
+
+}
+
+#ifndef PROJECT_NO_MAIN
+int main(int argc, char *argv[]) {
+
+	Settings settings = { EDMONDS_KARP, -1, std::vector<int>(), NULL };
+
+	Profiler profiler;
+	bool table = false;
+	const char *jsonFile = NULL;
+	const char *socketPath = NULL;
+	const char *outputDir = NULL;
+	int workers = 0;
+	std::vector<const char *> paths;
 
-	for (int i = 1; i < vertexNo - 1; i++) {
-		fscanf(stdin, "%d", &capacity);
-		g.loadSingleEdge(g.vertex(i), g.target(), capacity);
+	// Options
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-e") && i + 1 < argc) {
+			if (!parseEngine(argv[++i], settings.engine))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc)
+			settings.threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l") && i + 1 < argc) {
+			if (!parseList(argv[++i], settings.lambdas))
+				usage(argv[0]);
+		}
+		else if (!strcmp(argv[i], "-p"))
+			table = true;
+		else if (!strcmp(argv[i], "-P") && i + 1 < argc)
+			jsonFile = argv[++i];
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			socketPath = argv[++i];
+		else if (!strcmp(argv[i], "-b") && i + 1 < argc)
+			outputDir = argv[++i];
+		else if (!strcmp(argv[i], "-w") && i + 1 < argc)
+			workers = atoi(argv[++i]);
+		else if (argv[i][0] != '-')
+			paths.push_back(argv[i]);
+		else
+			usage(argv[0]);
 	}
 
-	for (int i = 1; i < vertexNo - 1; i++) {
-		if (i % n == 0)
-			continue;
-		fscanf(stdin, "%d", &capacity);
-		g.loadDoubleEdge(g.vertex(i), g.vertex(i + 1), capacity);
+	// Input files only in batch mode, and at least one there
+	if (paths.empty() != (outputDir == NULL))
+		usage(argv[0]);
+
+	// The profiler measures a single run
+	if ((socketPath != NULL || outputDir != NULL) && (table || jsonFile != NULL))
+		usage(argv[0]);
+
+	if (outputDir != NULL) {
+		std::vector<std::string> inputs;
+		if (socketPath != NULL)
+			usage(argv[0]);
+		listInputs(paths, inputs);
+		return batch(inputs, outputDir, workers, [&](FILE *in, FILE *out) {
+			Profiler profiler;
+			process(in, out, settings, profiler);
+		}) ? 0 : 1;
 	}
 
-	for (int i = 1; i < n * (m - 1) + 1; i++) {
-		fscanf(stdin, "%d", &capacity);
-		g.loadDoubleEdge(g.vertex(i), g.vertex(i + n), capacity);
+	if (socketPath != NULL) {
+		// Memory freed by a job stays with the process, already mapped, for the next one
+		mallopt(M_MMAP_THRESHOLD, 1 << 30);
+		mallopt(M_TRIM_THRESHOLD, -1);
+
+		if (settings.threads >= 0)
+			settings.pool = new ThreadPool(settings.threads);
+
+		Server server(socketPath);
+		bool stopped = server.run([&](FILE *in, FILE *out) { process(in, out, settings, profiler); });
+		delete settings.pool;
+		return stopped ? 0 : 1;
 	}
 
-	// Main procedure
-	mf.addStartingFlow();
+	if (table || jsonFile != NULL)
+		profiler.start();
 
-	fprintf(stdout, "%d\n\n", mf.edmondsKarp());
-	g.output(n);
+	try {
+		process(stdin, stdout, settings, profiler);
+	}
+	catch (const std::exception &e) {
+		fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return 1;
+	}
 
-	// Deletion of objects
-	g.unload();
+	if (table)
+		profiler.print(stderr);
+	if (jsonFile != NULL) {
+		FILE *out = fopen(jsonFile, "w");
+		if (out == NULL) {
+			fprintf(stderr, "%s: cannot write %s\n", argv[0], jsonFile);
+			return 1;
+		}
+		profiler.json(out);
+		fclose(out);
+	}
 
 	return 0;
 
 }
+#endif